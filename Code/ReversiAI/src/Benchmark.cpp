@@ -23,6 +23,7 @@
 
 #include "map.h"
 #include "algorithms.h"
+#include "transposition.h"
 
 using namespace std;
 
@@ -68,12 +69,25 @@ int main(int argc, char* argv[])
 			cout << "						5: alphabeta algorithm" << endl;
 			cout << "						6: alphabeta algorithm with move sorting" << endl;
 			cout << "						7: alphabeta algorithm with move sorting and aspirational windows" << endl;
+			cout << "						8: alphabeta algorithm with move sorting on several threads (lazy SMP)" << endl;
+			cout << "						9: alphabeta algorithm split over several threads (young brothers wait)" << endl;
+			cout << "						10: principal variation search with move sorting" << endl;
+			cout << "						11: best-reply search with move sorting" << endl;
+			cout << "						12: alphabeta algorithm with move sorting and the distant opponents merged into one ply" << endl;
 			cout << "	optional:" << endl;
 			cout << "		-h or --help			show this blob" <<endl;
 			cout << " 		-t or --timeLimit 		use this time limit for testing(in ms)" << endl;
 			cout << "						default is 10000ms" << endl;
 			cout << " 		-d or --depth			use this depth limit for testing" << endl;
 			cout << "						default is 4" << endl;
+			cout << " 		-n or --threads			use this amount of threads for lazy SMP and the split alphabeta" << endl;
+			cout << "						default is one per core" << endl;
+			cout << " 		-s or --tableSize		use this memory for the transposition table(in MB)" << endl;
+			cout << "						default is " << DEFAULT_TABLE_SIZE << "MB" << endl;
+			cout << " 		-w or --windowSize		use this half width of the first aspiration window(in percentage of the cells)" << endl;
+			cout << "						default is " << DEFAULT_WINDOW_SIZE << endl;
+			cout << " 		-c or --coalescingDepth		use this depth below which the ply of the merged opponents is skipped" << endl;
+			cout << "						default is " << DEFAULT_COALESCING_DEPTH << endl;
 		}
 		else if(cur.compare("-m")==0 || cur.compare("--map")==0)
 		{
@@ -96,7 +110,7 @@ int main(int argc, char* argv[])
 				testIndex=atoi(argv[i]);
 				i++;
 			}
-			if(testIndex<1 || testIndex>6)
+			if(testIndex<1 || testIndex>12)
 			{
 				cout << "-b or --benchmark was called with invalid parameters."<< endl;
 				return EXIT_FAILURE;
@@ -129,6 +143,66 @@ int main(int argc, char* argv[])
 				return EXIT_FAILURE;
 			}
 		}
+		else if(cur.compare("-n")==0 || cur.compare("--threads")==0)
+		{
+			i++;
+			int threads=0;
+			if(i<argc){
+				threads=atoi(argv[i]);
+				i++;
+			}
+			if(threads<=0)
+			{
+				cout << "-n or --threads was called with invalid parameters." << endl;
+				return EXIT_FAILURE;
+			}
+			setThreadCount(threads);
+		}
+		else if(cur.compare("-s")==0 || cur.compare("--tableSize")==0)
+		{
+			i++;
+			int tableSize=0;
+			if(i<argc){
+				tableSize=atoi(argv[i]);
+				i++;
+			}
+			if(tableSize<=0)
+			{
+				cout << "-s or --tableSize was called with invalid parameters." << endl;
+				return EXIT_FAILURE;
+			}
+			setTranspositionTableSize(tableSize);
+		}
+		else if(cur.compare("-w")==0 || cur.compare("--windowSize")==0)
+		{
+			i++;
+			double windowSize=0;
+			if(i<argc){
+				windowSize=atof(argv[i]);
+				i++;
+			}
+			if(windowSize<=0)
+			{
+				cout << "-w or --windowSize was called with invalid parameters." << endl;
+				return EXIT_FAILURE;
+			}
+			setWindowSize(windowSize);
+		}
+		else if(cur.compare("-c")==0 || cur.compare("--coalescingDepth")==0)
+		{
+			i++;
+			int coalescingDepth=-1;
+			if(i<argc){
+				coalescingDepth=atoi(argv[i]);
+				i++;
+			}
+			if(coalescingDepth<0)
+			{
+				cout << "-c or --coalescingDepth was called with invalid parameters." << endl;
+				return EXIT_FAILURE;
+			}
+			setCoalescingDepth(coalescingDepth);
+		}
 		else
 		{
 			cout << "Call " << program << " with valid parameters." << endl;
@@ -174,12 +248,20 @@ int main(int argc, char* argv[])
 					break;
 		case(7): 	benchmarkSearchAlgorithm(map, ASPIRATIONAL_WINDOW ,depthLimit);
 					break;
+		case(8): 	benchmarkSearchAlgorithm(map, LAZY_SMP ,depthLimit);
+					break;
+		case(9): 	benchmarkSearchAlgorithm(map, PARALLEL_ALPHABETA ,depthLimit);
+					break;
+		case(10): 	benchmarkSearchAlgorithm(map, PRINCIPAL_VARIATION ,depthLimit);
+					break;
+		case(11): 	benchmarkSearchAlgorithm(map, BEST_REPLY ,depthLimit);
+					break;
+		case(12): 	benchmarkSearchAlgorithm(map, OPPONENT_COALESCING ,depthLimit);
+					break;
 		default:
 					break;
 	}
 
-	freeAllocatedMemory();
-
 	return EXIT_SUCCESS;
 }
 
@@ -246,6 +328,26 @@ void benchmarkSearchAlgorithm(Map& map, int index ,int depth)
 	{
 		getNextMove(map, depth, 0, 1, ASPIRATIONAL_WINDOW, true);
 	}
+	else if(index==LAZY_SMP)
+	{
+		getNextMove(map, depth, 0, 1, LAZY_SMP, true);
+	}
+	else if(index==PARALLEL_ALPHABETA)
+	{
+		getNextMove(map, depth, 0, 1, PARALLEL_ALPHABETA, true);
+	}
+	else if(index==PRINCIPAL_VARIATION)
+	{
+		getNextMove(map, depth, 0, 1, PRINCIPAL_VARIATION, true);
+	}
+	else if(index==BEST_REPLY)
+	{
+		getNextMove(map, depth, 0, 1, BEST_REPLY, true);
+	}
+	else if(index==OPPONENT_COALESCING)
+	{
+		getNextMove(map, depth, 0, 1, OPPONENT_COALESCING, true);
+	}
 
 	clock_gettime(CLOCK_REALTIME, &spec);
 	long timePassed = ((spec.tv_sec*1000)+(spec.tv_nsec/1000000))-startTime;
@@ -266,4 +368,24 @@ void benchmarkSearchAlgorithm(Map& map, int index ,int depth)
 	cout << "Average nodes per second:		" << average << " evaluations per second" << endl;
 	cout << "Time spend evaluating leafs:		" << timeSpendEvaluating << " ms" << endl;
 	cout << "Percentage of time spend evaluating:	" << percentageEvaluating << " %" << endl;
+	cout << "Transposition table probes:		" << getTranspositionTableProbes() << endl;
+	cout << "Transposition table hits:		" << getTranspositionTableHits() << endl;
+	cout << "Transposition table collisions:		" << getTranspositionTableCollisions() << endl;
+
+	uint64_t cutoffs = getCutoffs();
+	if(cutoffs>0)
+	{
+		cout << "Cutoffs by the first move:		" << getFirstMoveCutoffs()*100.0/cutoffs << " % of " << cutoffs << " cutoffs" << endl;
+	}
+
+	if(index==ASPIRATIONAL_WINDOW)
+	{
+		WindowStatistics windows = getWindowStatistics();
+		cout << "Aspiration window fails low/high:	" << windows.failLows << "/" << windows.failHighs << " in " << windows.iterations << " iterations" << endl;
+		cout << "Nodes in failed window searches:	" << windows.failedNodes << " of " << windows.nodes << endl;
+		if(windows.scoreChanges>0)
+		{
+			cout << "Average value change per iteration:	" << windows.scoreChangeSum/windows.scoreChanges << endl;
+		}
+	}
 }
@@ -10,16 +10,25 @@
 #include <string.h>		// std::string
 #include <sstream>		// std::istringstream
 #include <fstream>		// std::ifstream
+#include <future>		// std::future
+#include <chrono>		// std::chrono::milliseconds
+#include <algorithm>	// std::max
 
 #include "map.h"
 #include "client.h"
 #include "algorithms.h"
+#include "transposition.h"
 
 using namespace std;
 
 int play(string ip, string port, int algo);
 int test(char* path);
-void freeMemory();
+Move searchMove(Map& map, int algo, bool isPlayingPhase);
+void startPondering(Map& map, Map& ponderMap, future<void>& pondering, uint8_t lastPlayer, int algo, bool isPlayingPhase);
+void stopPondering(future<void>& pondering);
+
+// The time in ms before the time limit of the server, at which a search that has not returned yet gets stopped
+#define STOP_RESERVE 100
 
 uint8_t player=1;
 
@@ -34,8 +43,6 @@ const string version = "v6.00.01";
  */
 int main(int argc, char* argv[])
 {
-	initTimer();
-
 	string program = argv[0];
 
 	char* path=(char*)"";
@@ -67,7 +74,14 @@ int main(int argc, char* argv[])
 			cout << "						2: alphabeta" << endl;
 			cout << "						3: alphabeta with move sorting" << endl;
 			cout << "						4: alphabeta algorithm with move sorting and aspiration windows" << endl;
+			cout << "						5: alphabeta with move sorting on several threads (lazy SMP)" << endl;
+			cout << "						6: alphabeta split over several threads (young brothers wait)" << endl;
+			cout << "						7: principal variation search with move sorting" << endl;
+			cout << "						8: best-reply search with move sorting" << endl;
+			cout << "						9: alphabeta with move sorting and the distant opponents merged into one ply" << endl;
 			cout << "	optional:" << endl;
+			cout << "		-n or --threads <count>		threads used by algorithm 5 and 6 (default: one per core)" << endl;
+			cout << "		-s or --tableSize <MB>		memory used by the transposition table (default: " << DEFAULT_TABLE_SIZE << ")" << endl;
 			cout << "		-h or --help			show this blob" <<endl;
 			cout << "		-v or --version			show the version number" <<endl;
 			return EXIT_SUCCESS;
@@ -113,13 +127,45 @@ int main(int argc, char* argv[])
 				return EXIT_FAILURE;
 			}
 
-			if(algo<1 || algo>4)
+			if(algo<1 || algo>9)
 			{
 				cout << "-a or --algorithm was called with invalid parameters."<< endl;
 				return EXIT_FAILURE;
 			}
 
 		}
+		else if(cur.compare("-n")==0 || cur.compare("--threads")==0)
+		{
+			i++;
+			int threads=0;
+			if(i<argc){
+				threads=atoi(argv[i]);
+				i++;
+			}
+
+			if(threads<=0)
+			{
+				cout << "-n or --threads was called with invalid parameters."<< endl;
+				return EXIT_FAILURE;
+			}
+			setThreadCount(threads);
+		}
+		else if(cur.compare("-s")==0 || cur.compare("--tableSize")==0)
+		{
+			i++;
+			int tableSize=0;
+			if(i<argc){
+				tableSize=atoi(argv[i]);
+				i++;
+			}
+
+			if(tableSize<=0)
+			{
+				cout << "-s or --tableSize was called with invalid parameters."<< endl;
+				return EXIT_FAILURE;
+			}
+			setTranspositionTableSize(tableSize);
+		}
 		else if(cur.compare("-i")==0 || cur.compare("--ip")==0)
 		{
 			i++;
@@ -169,11 +215,72 @@ int main(int argc, char* argv[])
 					break;
 	}
 
-	freeMemory();
-
 	return EXIT_SUCCESS;
 }
 
+/**
+ * Searches our next move on a thread of its own and waits for it. The search stops itself by polling its deadline,
+ * this thread does nothing else in the meantime. It only stops the search as a safety measure, if the search has not
+ * returned STOP_RESERVE ms before the time limit of the server.
+ *
+ * @param map - The current state of the game
+ * @param algo - The identifier of the search algorithm
+ * @param isPlayingPhase - Set if we are in the playing phase, unset for the bombing phase
+ * @return The best move found
+ */
+Move searchMove(Map& map, int algo, bool isPlayingPhase)
+{
+	future<SearchResult&> pendingSearch = searchNextMoveAsync(map, getSearchDepth(), getTimeLimit(), player, algo, isPlayingPhase);
+
+	if(getSearchDepth()==0)
+	{
+		int timeLeft = max(0, (int)getTimeLimit()-STOP_RESERVE);
+		if(pendingSearch.wait_for(chrono::milliseconds(timeLeft))==future_status::timeout)
+		{
+			cout << "G3-Main: Search did not return in time, stopping it" << endl;
+			stopSearching();
+		}
+	}
+
+	return pendingSearch.get().move;
+}
+
+/**
+ * Starts searching the current state of the game on a thread of its own, while the other players think about
+ * their moves. The positions found are kept in the transposition table, where the search of our next move finds them.
+ * MINIMAX does not use the table, and BEST_REPLY and OPPONENT_COALESCING do not find the positions of the paranoid
+ * pondering in it, so there is no pondering for them.
+ *
+ * @param map - The current state of the game
+ * @param ponderMap - Gets a copy of the state of the game, which is searched by the pondering
+ * @param pondering - Is set to the future of the pondering
+ * @param lastPlayer - The player who made the last move
+ * @param algo - The identifier of the search algorithm
+ * @param isPlayingPhase - Set if we are in the playing phase, unset for the bombing phase
+ */
+void startPondering(Map& map, Map& ponderMap, future<void>& pondering, uint8_t lastPlayer, int algo, bool isPlayingPhase)
+{
+	if(algo!=MINIMAX && algo!=BEST_REPLY && algo!=OPPONENT_COALESCING)
+	{
+		ponderMap.copy(map);
+		pondering = ponderAsync(ponderMap, lastPlayer, player, algo, isPlayingPhase);
+	}
+}
+
+/**
+ * Stops the pondering if it is running and waits until its thread is done.
+ *
+ * @param pondering - The future of the pondering
+ */
+void stopPondering(future<void>& pondering)
+{
+	if(pondering.valid())
+	{
+		stopSearching();
+		pondering.get();
+	}
+}
+
 /**
  * This method is responsible for the normal game flow.
  * It will first setup a connection to the specified host,
@@ -191,9 +298,23 @@ int play(string ip, string port, int algo)
 	Map map = getMap();
 	map.draw();
 
+	// The pondering during the turns of the other players, which is stopped by every message of the server.
+	// Until our first move it starts with the opening analysis for all seats, as our own seat is not known yet.
+	Map ponderMap;
+	future<void> pondering;
+	if(algo!=MINIMAX && algo!=BEST_REPLY && algo!=OPPONENT_COALESCING)
+	{
+		ponderMap.copy(map);
+		pondering = analyseOpeningsAsync(ponderMap, algo, true);
+	}
+
 	player = getPlayerNumber();
 	cout << "G3-Main: Player number for this game is " << (int)player << endl;
 
+	// Only our seat is searched from now on, the first move is made by player 1
+	stopPondering(pondering);
+	startPondering(map, ponderMap, pondering, map.getAmountOfPlayers(), algo, true);
+
 	bool isPlayingPhaseRunning = true;
 	bool isBombingPhaseRunning = false;
 
@@ -202,6 +323,7 @@ int play(string ip, string port, int algo)
 		// Wait for the server to send a message and act accordingly
 		// Repeat until the server changes the state of the game
 		listenToServer();
+		stopPondering(pondering);
 
 		uint8_t messageType = getLatestMessageType();
 
@@ -209,7 +331,7 @@ int play(string ip, string port, int algo)
 		{
 			map.initializeNeighbourList(player);
 			cout << "G3-Main: Searching valid move with " << map.getAmountOfOverrideStones(player) << " override stones" << endl;
-			Move move = *getNextMove(map, getSearchDepth(), getTimeLimit() , player , algo, true);
+			Move move = searchMove(map, algo, true);
 			cout << "G3-Main: Move found: (" << move.x << ", " << move.y << ", " << (int)move.choice << ")" << endl;
 			sendMove(move);
 		}
@@ -219,12 +341,13 @@ int play(string ip, string port, int algo)
 			Move move = getMove();
 			setConsiderOverrideStones(true);
 			cout << "G3-Main: Player " << (int)move.player << " placed a stone on Cell (" << move.x << "," << move.y << ")" << endl;
-			if(!map.isPlayingPhaseMoveValid(getOffset(move.x,move.y),move.player,move.choice))
+			if(!map.isPlayingPhaseMoveValid(map.getOffset(move.x,move.y),move.player,move.choice))
 			{
 				cout << "G3-Error: Invalid move received from server" << endl;
 			}
 			cout << "G3-Main: Player " << (int)move.player << " has " << map.getAmountOfOverrideStones(move.player) << " override stones and " << map.getAmountOfBombs(move.player) << " bombs left." << endl;
 			cout << endl;
+			startPondering(map, ponderMap, pondering, move.player, algo, true);
 		}
 		else if(messageType == 7)	// A player made an invalid move and got disqualified
 		{
@@ -235,7 +358,7 @@ int play(string ip, string port, int algo)
 				isPlayingPhaseRunning = false;
 			}
 
-			disqualifyPlayer(player);
+			map.disqualifyPlayer(player);
 		}
 		else if(messageType == 8)	// First phase has ended
 		{
@@ -259,12 +382,13 @@ int play(string ip, string port, int algo)
 	while(isBombingPhaseRunning)	// Second stage
 	{
 		listenToServer();
+		stopPondering(pondering);
 
 		uint8_t messageType = getLatestMessageType();
 
 		if(messageType == 4)	// Our turn
 		{
-			Move move = *getNextMove(map, getSearchDepth(), getTimeLimit(), player, algo, false);
+			Move move = searchMove(map, algo, false);
 			cout << "G3-Main: Bomb placed on Cell (" << move.x << "," << move.y << ")" << endl;
 			sendMove(move);
 		}
@@ -272,8 +396,9 @@ int play(string ip, string port, int algo)
 		{
 			Move move = getMove();
 			cout << "G3-Main: Player " << (int)move.player << " placed a bomb on Cell (" << move.x << "," << move.y << ")" << endl;
-			map.isBombingPhaseMoveValid(getOffset(move.x,move.y), move.player, move.choice);
+			map.isBombingPhaseMoveValid(map.getOffset(move.x,move.y), move.player, move.choice);
 			map.draw();
+			startPondering(map, ponderMap, pondering, move.player, algo, false);
 		}
 		else if(messageType == 7)	// A player made an invalid move and got disqualified
 		{
@@ -284,7 +409,7 @@ int play(string ip, string port, int algo)
 				isBombingPhaseRunning = false;
 			}
 
-			disqualifyPlayer(player);
+			map.disqualifyPlayer(player);
 		}
 		else if(messageType == 9)	// Second phase has ended
 		{
@@ -298,8 +423,11 @@ int play(string ip, string port, int algo)
 		}
 	}
 
+	stopPondering(pondering);
 	closeConnection();
 
+	close();	// display how well the time limits were used
+
 	return EXIT_SUCCESS;
 }
 
@@ -324,11 +452,3 @@ int test(char* path)
 
 	return EXIT_SUCCESS;
 }
-
-/**
- * Calls all the functions that frees the necessary space for exiting the program.
- */
-void freeMemory()
-{
-	freeAllocatedMemory();
-}
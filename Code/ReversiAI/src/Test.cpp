@@ -8,6 +8,7 @@
 #include <limits>
 #include <string>
 #include <fstream>
+#include <sstream>
 #include <ctime>	// clock()
 #include <cstdlib>	// _sleep
 #include <unistd.h>
@@ -19,6 +20,101 @@
 
 using namespace std;
 
+/**
+ * Compares a map on which a move has been made and taken back with the copy taken before the move.
+ * Every difference in the board, the stone counts, the hash keys or the evaluation is printed.
+ *
+ * @param map - The map on which the move has been made and taken back
+ * @param original - The copy of the map taken before the move
+ * @return The amount of differences found
+ */
+int compareRoundTrip(Map& map, Map& original)
+{
+	int differences=0;
+
+	for(uint16_t cell=0; cell<map.getAmountOfCells(); ++cell)
+	{
+		if(map.getState(cell)!=original.getState(cell))
+		{
+			cout << " Cell " << cell << " has not been restored!" << endl;
+			differences++;
+		}
+	}
+
+	if(map.getAmountOfInversionStones()!=original.getAmountOfInversionStones())
+	{
+		cout << " The inversion stones have not been restored!" << endl;
+		differences++;
+	}
+
+	for(uint8_t player=1; player<=map.getAmountOfPlayers(); ++player)
+	{
+		if(map.getAmountOfOverrideStones(player)!=original.getAmountOfOverrideStones(player)
+			|| map.getAmountOfBombs(player)!=original.getAmountOfBombs(player))
+		{
+			cout << " The stones of player " << (int)player << " have not been restored!" << endl;
+			differences++;
+		}
+		if(map.getHashKey(player, true)!=original.getHashKey(player, true)
+			|| map.getHashKey(player, false)!=original.getHashKey(player, false))
+		{
+			cout << " The hash key for player " << (int)player << " has not been restored!" << endl;
+			differences++;
+		}
+		if(map.evaluateForPlayingPhase(player)!=original.evaluateForPlayingPhase(player))
+		{
+			cout << " The evaluation for player " << (int)player << " has not been restored!" << endl;
+			differences++;
+		}
+	}
+
+	return differences;
+}
+
+/**
+ * Writes the current board of a map into the text of the map file it was loaded from. A map parsed from
+ * the result computes its stability, ratings and hash key from scratch. The stone counts are the ones of the file.
+ *
+ * @param map - The map whose board is written
+ * @param mapFile - The text of the map file the map was loaded from
+ * @return The text of the map file with the current board
+ */
+string writeBoard(Map& map, const string& mapFile)
+{
+	istringstream lines(mapFile);
+	ostringstream result;
+	string line;
+
+	// The header with the players, the stones and the size is kept
+	for(int i=0; i<4 && getline(lines, line); ++i)
+	{
+		result << line << '\n';
+	}
+
+	for(int y=0; y<map.getHeight(); ++y)
+	{
+		getline(lines, line);
+		for(int x=0; x<map.getWidth(); ++x)
+		{
+			uint16_t cell = map.getOffset(x,y);
+			char state = cell==NO_CELL ? '-' : map.getState(cell);
+			if(state>=0 && state<=MAX_PLAYER)
+			{
+				state += '0';
+			}
+			result << state << (x+1<map.getWidth() ? ' ' : '\n');
+		}
+	}
+
+	// The transitions are kept as well
+	while(getline(lines, line))
+	{
+		result << line << '\n';
+	}
+
+	return result.str();
+}
+
 int main(int argc, char* argv[])
 {
 	int errorCount = 0;
@@ -48,7 +144,7 @@ int main(int argc, char* argv[])
 		{
 			mapCopy1.copy(map1);
 
-			if(mapCopy1.isPlayingPhaseMoveValid(getOffset(x,y),1,0))
+			if(mapCopy1.isPlayingPhaseMoveValid(mapCopy1.getOffset(x,y),1,0))
 			{
 				if(x==y)
 				{
@@ -69,7 +165,6 @@ int main(int argc, char* argv[])
 		}
 	}
 
-	freeAllocatedMemory();
 	if(!error)
 	{
 		cout << "Test 1 passed!!!" << endl;
@@ -97,7 +192,7 @@ int main(int argc, char* argv[])
 		for(int x=0; x<5; x++)
 		{
 			mapCopy3.copy(map3);
-			if(mapCopy3.isBombingPhaseMoveValid(getOffset(x,y),1,0))
+			if(mapCopy3.isBombingPhaseMoveValid(mapCopy3.getOffset(x,y),1,0))
 			{
 				if(x==y)
 				{
@@ -117,7 +212,6 @@ int main(int argc, char* argv[])
 			}
 		}
 	}
-	freeAllocatedMemory();
 	if(!error)
 	{
 		cout << "Test 3 passed!!!" << endl;
@@ -139,14 +233,14 @@ int main(int argc, char* argv[])
 	Map map4(file4);
 	file4.close();
 
-	map4.isBombingPhaseMoveValid(getOffset(5,5),1,0);
+	map4.isBombingPhaseMoveValid(map4.getOffset(5,5),1,0);
 	for(int y=0; y<11; y++)
 	{
 		for(int x=0; x<11; x++)
 		{
 			if((x>3 && x<7) || (y>2 && y<8))
 			{
-				if(getOffset(x,y)!=NO_STONE && map4.getState(getOffset(x,y))!=NO_CELL)
+				if(map4.getOffset(x,y)!=NO_CELL && map4.getState(map4.getOffset(x,y))!=NO_STONE)
 				{
 				cout << "Cell ("<<x<<","<<y<<") should not exist anymore!" << endl;
 				error=true;
@@ -155,7 +249,7 @@ int main(int argc, char* argv[])
 			}
 			else
 			{
-				if(map4.getState(getOffset(x,y))==NO_CELL)
+				if(map4.getOffset(x,y)==NO_CELL || map4.getState(map4.getOffset(x,y))==NO_STONE)
 				{
 				cout << "Cell ("<<x<<","<<y<<") should still exist!" << endl;
 				error=true;
@@ -165,7 +259,474 @@ int main(int argc, char* argv[])
 		}
 	}
 
-	freeAllocatedMemory();
+	//END OF TEST 3
+	cout << endl << endl;
+
+	/*
+	 * TEST 4
+	 * Checks if every valid move of the playing and the bombing phase is taken back completely
+	 */
+	cout << "Executing Test 5" << endl;
+	ifstream file5("testdata/test2.txt");
+	if(!file5.is_open())
+	{
+		cout << "Loading Map failed!"<< endl;
+		return EXIT_FAILURE;
+	}
+	Map map5(file5);
+	file5.close();
+	Map original5;
+	original5.copy(map5);
+
+	uint16_t captures5[map5.getMaximumCaptureCount()];
+	Move moveBuffer5[map5.getMaximumMoveCount()];
+	UndoRecord undo5;
+	int moveCount5=0;
+	for(int phase=0; phase<2; ++phase)
+	{
+		bool isPlayingPhase = phase==0;
+		for(uint8_t player=1; player<=map5.getAmountOfPlayers(); ++player)
+		{
+			MoveList moves = {moveBuffer5, 0};
+			map5.generateMoves(player, isPlayingPhase, moves);
+			for(int m=0; m<moves.count; ++m)
+			{
+				Move& move = moves.moves[m];
+				if(!map5.makeMove(move.cell, move.player, move.choice, isPlayingPhase, captures5, undo5))
+				{
+					cout << " Move on cell "<<move.cell<<" of player "<<(int)move.player<<" should be valid!" << endl;
+					error=true;
+					errorCount++;
+					continue;
+				}
+				map5.unmakeMove(undo5);
+				moveCount5++;
+
+				int differences = compareRoundTrip(map5, original5);
+				if(differences>0)
+				{
+					cout << " Move on cell "<<move.cell<<" of player "<<(int)move.player<<" was not taken back!" << endl;
+					error=true;
+					errorCount+=differences;
+				}
+			}
+		}
+	}
+
+	if(moveCount5==0)
+	{
+		cout << " No move has been tried!" << endl;
+		error=true;
+		errorCount++;
+	}
+	if(!error)
+	{
+		cout << "Test 5 passed!!!" << endl;
+	}
+	//END OF TEST 4
+	cout << endl << endl;
+
+	/*
+	 * TEST 5
+	 * Checks if the moves generated from the candidate cells are the same again after a move has been taken back,
+	 * also when the move is taken back below another move
+	 */
+	cout << "Executing Test 6" << endl;
+	ifstream file6("testdata/test2.txt");
+	if(!file6.is_open())
+	{
+		cout << "Loading Map failed!"<< endl;
+		return EXIT_FAILURE;
+	}
+	Map map6(file6);
+	file6.close();
+
+	uint16_t captures6[map6.getMaximumCaptureCount()];
+	Move moveBuffer6[map6.getMaximumMoveCount()];
+	Move replyBuffer6[map6.getMaximumMoveCount()];
+	Move checkBuffer6[map6.getMaximumMoveCount()];
+	UndoRecord undo6;
+	UndoRecord replyUndo6;
+
+	MoveList moves6 = {moveBuffer6, 0};
+	map6.generateMoves(1, true, moves6);
+	for(int m=0; m<moves6.count; ++m)
+	{
+		Move& move = moves6.moves[m];
+		map6.makeMove(move.cell, move.player, move.choice, true, captures6, undo6);
+
+		// The replies of the next player are generated again after each of them has been taken back
+		MoveList replies = {replyBuffer6, 0};
+		map6.generateMoves(2, true, replies);
+		for(int r=0; r<replies.count; ++r)
+		{
+			Move& reply = replies.moves[r];
+			map6.makeMove(reply.cell, reply.player, reply.choice, true, captures6, replyUndo6);
+			map6.unmakeMove(replyUndo6);
+
+			MoveList check = {checkBuffer6, 0};
+			map6.generateMoves(2, true, check);
+			bool isSame = check.count==replies.count;
+			for(int i=0; isSame && i<check.count; ++i)
+			{
+				isSame = check.moves[i].cell==replies.moves[i].cell && check.moves[i].player==replies.moves[i].player
+					&& check.moves[i].choice==replies.moves[i].choice;
+			}
+			if(!isSame)
+			{
+				cout << " Moves changed after the reply on cell "<<reply.cell<<" to the move on cell "<<move.cell<<"!" << endl;
+				error=true;
+				errorCount++;
+			}
+		}
+
+		map6.unmakeMove(undo6);
+
+		MoveList check = {checkBuffer6, 0};
+		map6.generateMoves(1, true, check);
+		bool isSame = check.count==moves6.count;
+		for(int i=0; isSame && i<check.count; ++i)
+		{
+			isSame = check.moves[i].cell==moves6.moves[i].cell && check.moves[i].player==moves6.moves[i].player
+				&& check.moves[i].choice==moves6.moves[i].choice;
+		}
+		if(!isSame)
+		{
+			cout << " Moves changed after the move on cell "<<move.cell<<"!" << endl;
+			error=true;
+			errorCount++;
+		}
+	}
+
+	if(moves6.count==0)
+	{
+		cout << " No move has been generated!" << endl;
+		error=true;
+		errorCount++;
+	}
+	if(!error)
+	{
+		cout << "Test 6 passed!!!" << endl;
+	}
+	//END OF TEST 5
+	cout << endl << endl;
+
+	/*
+	 * TEST 6
+	 * Checks if the stability that is kept up to date during a line of moves is the one computed from scratch
+	 */
+	cout << "Executing Test 7" << endl;
+	ifstream file7("testdata/test2.txt");
+	if(!file7.is_open())
+	{
+		cout << "Loading Map failed!"<< endl;
+		return EXIT_FAILURE;
+	}
+	stringstream mapFile7;
+	mapFile7 << file7.rdbuf();
+	file7.close();
+	mapFile7.seekg(0);
+	Map map7(mapFile7);
+
+	uint16_t captures7[map7.getMaximumCaptureCount()];
+	Move moveBuffer7[map7.getMaximumMoveCount()];
+	UndoRecord undo7;
+
+	// Follow the last generated move of the player in turn, the stone ratings only depend on the stability and the board
+	uint8_t turn7=1;
+	for(int madeMoves=1; madeMoves<=16; ++madeMoves)
+	{
+		MoveList moves = {moveBuffer7, 0};
+		map7.generateMoves(turn7, true, moves);
+		if(moves.count==0)
+		{
+			break;
+		}
+		Move& move = moves.moves[moves.count-1];
+		map7.makeMove(move.cell, move.player, move.choice, true, captures7, undo7);
+
+		istringstream board(writeBoard(map7, mapFile7.str()));
+		Map fromScratch(board);
+		for(uint8_t player=1; player<=map7.getAmountOfPlayers(); ++player)
+		{
+			if(map7.evaluateForPlayingPhaseFromScratch(player)!=fromScratch.evaluateForPlayingPhaseFromScratch(player))
+			{
+				cout << " The stability for player "<<(int)player<<" differs from scratch after move "<<madeMoves<<"!" << endl;
+				error=true;
+				errorCount++;
+			}
+		}
+		turn7 = map7.getNextPlayer(turn7);
+	}
+
+	if(!error)
+	{
+		cout << "Test 7 passed!!!" << endl;
+	}
+	//END OF TEST 6
+	cout << endl << endl;
+
+	/*
+	 * TEST 7
+	 * Checks if the stone ratings kept between the evaluations are up to date during a line of moves
+	 * and after the line has been taken back
+	 */
+	cout << "Executing Test 8" << endl;
+	ifstream file8("testdata/test2.txt");
+	if(!file8.is_open())
+	{
+		cout << "Loading Map failed!"<< endl;
+		return EXIT_FAILURE;
+	}
+	Map map8(file8);
+	file8.close();
+	Map original8;
+	original8.copy(map8);
+
+	uint16_t captures8[map8.getMaximumCaptureCount()];
+	Move moveBuffer8[map8.getMaximumMoveCount()];
+	UndoRecord undo8[16];
+	int madeMoves8=0;
+
+	uint8_t turn8=1;
+	while(madeMoves8<16)
+	{
+		MoveList moves = {moveBuffer8, 0};
+		map8.generateMoves(turn8, true, moves);
+		if(moves.count==0)
+		{
+			break;
+		}
+		Move& move = moves.moves[moves.count-1];
+		map8.makeMove(move.cell, move.player, move.choice, true, captures8, undo8[madeMoves8++]);
+
+		for(uint8_t player=1; player<=map8.getAmountOfPlayers(); ++player)
+		{
+			if(map8.evaluateForPlayingPhase(player)!=map8.evaluateForPlayingPhaseFromScratch(player))
+			{
+				cout << " The evaluation for player "<<(int)player<<" is outdated after move "<<madeMoves8<<"!" << endl;
+				error=true;
+				errorCount++;
+			}
+		}
+		turn8 = map8.getNextPlayer(turn8);
+	}
+
+	while(madeMoves8>0)
+	{
+		map8.unmakeMove(undo8[--madeMoves8]);
+	}
+
+	int differences8 = compareRoundTrip(map8, original8);
+	if(differences8>0)
+	{
+		cout << " The line of moves was not taken back!" << endl;
+		error=true;
+		errorCount+=differences8;
+	}
+	if(!error)
+	{
+		cout << "Test 8 passed!!!" << endl;
+	}
+	//END OF TEST 7
+	cout << endl << endl;
+
+	/*
+	 * TEST 8
+	 * Checks if the hash keys updated during a line of moves are the ones of the boards computed from scratch,
+	 * and if they are restored after the line has been taken back
+	 */
+	cout << "Executing Test 9" << endl;
+	ifstream file9("testdata/test2.txt");
+	if(!file9.is_open())
+	{
+		cout << "Loading Map failed!"<< endl;
+		return EXIT_FAILURE;
+	}
+	stringstream mapFile9;
+	mapFile9 << file9.rdbuf();
+	file9.close();
+	mapFile9.seekg(0);
+	Map map9(mapFile9);
+	Map original9;
+	original9.copy(map9);
+
+	uint16_t captures9[map9.getMaximumCaptureCount()];
+	Move moveBuffer9[map9.getMaximumMoveCount()];
+	UndoRecord undo9[16];
+	int madeMoves9=0;
+
+	uint8_t turn9=1;
+	while(madeMoves9<16)
+	{
+		MoveList moves = {moveBuffer9, 0};
+		map9.generateMoves(turn9, true, moves);
+		if(moves.count==0)
+		{
+			break;
+		}
+		Move& move = moves.moves[moves.count-1];
+		map9.makeMove(move.cell, move.player, move.choice, true, captures9, undo9[madeMoves9++]);
+
+		istringstream board(writeBoard(map9, mapFile9.str()));
+		Map fromScratch(board);
+		for(uint8_t player=1; player<=map9.getAmountOfPlayers(); ++player)
+		{
+			if(map9.getHashKey(player, true)!=fromScratch.getHashKey(player, true))
+			{
+				cout << " The hash key for player "<<(int)player<<" differs from scratch after move "<<madeMoves9<<"!" << endl;
+				error=true;
+				errorCount++;
+			}
+		}
+		turn9 = map9.getNextPlayer(turn9);
+	}
+
+	while(madeMoves9>0)
+	{
+		map9.unmakeMove(undo9[--madeMoves9]);
+	}
+
+	for(uint8_t player=1; player<=map9.getAmountOfPlayers(); ++player)
+	{
+		if(map9.getHashKey(player, true)!=original9.getHashKey(player, true)
+			|| map9.getHashKey(player, false)!=original9.getHashKey(player, false))
+		{
+			cout << " The hash key for player "<<(int)player<<" has not been restored!" << endl;
+			error=true;
+			errorCount++;
+		}
+	}
+	if(!error)
+	{
+		cout << "Test 9 passed!!!" << endl;
+	}
+	//END OF TEST 8
+	cout << endl << endl;
+
+	/*
+	 * TEST 9
+	 * Checks if a game played on the topology of another map leaves that map untouched
+	 */
+	cout << "Executing Test 10" << endl;
+	ifstream file10("testdata/test2.txt");
+	if(!file10.is_open())
+	{
+		cout << "Loading Map failed!"<< endl;
+		return EXIT_FAILURE;
+	}
+	Map map10(file10);
+	file10.close();
+	Map original10;
+	original10.copy(map10);
+	Map sharing10(map10.getTopology());
+
+	uint16_t captures10[sharing10.getMaximumCaptureCount()];
+	Move moveBuffer10[sharing10.getMaximumMoveCount()];
+	UndoRecord undo10;
+
+	uint8_t turn10=1;
+	for(int madeMoves=0; madeMoves<16; ++madeMoves)
+	{
+		MoveList moves = {moveBuffer10, 0};
+		sharing10.generateMoves(turn10, true, moves);
+		if(moves.count==0)
+		{
+			break;
+		}
+		Move& move = moves.moves[moves.count-1];
+		sharing10.makeMove(move.cell, move.player, move.choice, true, captures10, undo10);
+		turn10 = sharing10.getNextPlayer(turn10);
+	}
+
+	int differences10 = compareRoundTrip(map10, original10);
+	if(differences10>0)
+	{
+		cout << " The moves on the shared topology changed the other map!" << endl;
+		error=true;
+		errorCount+=differences10;
+	}
+	if(!error)
+	{
+		cout << "Test 10 passed!!!" << endl;
+	}
+	//END OF TEST 9
+	cout << endl << endl;
+
+	/*
+	 * TEST 10
+	 * Checks if the moves found with the bitboards are the ones the validation of every single cell finds,
+	 * on maps with transitions and with as well as without considering override stones
+	 */
+	cout << "Executing Test 11" << endl;
+	const char* mapFiles11[] = {"testdata/test2.txt", "Benchmarking/g5_1.map"};
+	for(int f=0; f<2; ++f)
+	{
+		ifstream file11(mapFiles11[f]);
+		if(!file11.is_open())
+		{
+			cout << "Loading Map failed!"<< endl;
+			return EXIT_FAILURE;
+		}
+		Map map11(file11);
+		file11.close();
+		Map validation11;
+
+		uint16_t captures11[map11.getMaximumCaptureCount()];
+		Move moveBuffer11[map11.getMaximumMoveCount()];
+		UndoRecord undo11;
+
+		uint8_t turn11=1;
+		for(int madeMoves=0; madeMoves<24; ++madeMoves)
+		{
+			setConsiderOverrideStones(madeMoves%2==0);
+			for(uint8_t player=1; player<=map11.getAmountOfPlayers(); ++player)
+			{
+				MoveList moves = {moveBuffer11, 0};
+				map11.generateMoves(player, true, moves);
+
+				int m=0;
+				bool isSame=true;
+				for(uint16_t cell=0; cell<map11.getAmountOfCells(); ++cell)
+				{
+					uint8_t state = map11.getState(cell);
+					uint8_t firstChoice = state=='c' ? 1 : (state=='b' ? 20 : 0);
+					uint8_t lastChoice = state=='c' ? map11.getAmountOfPlayers() : (state=='b' ? 21 : 0);
+					for(uint8_t choice=firstChoice; choice<=lastChoice; ++choice)
+					{
+						validation11.copy(map11);
+						if(validation11.isPlayingPhaseMoveValid(cell, player, choice))
+						{
+							isSame = isSame && m<moves.count && moves.moves[m].cell==cell && moves.moves[m].choice==choice;
+							++m;
+						}
+					}
+				}
+				if(!isSame || m!=moves.count)
+				{
+					cout << " The generated moves of player "<<(int)player<<" on "<<mapFiles11[f]<<" differ from the valid ones after "<<madeMoves<<" moves!" << endl;
+					error=true;
+					errorCount++;
+				}
+			}
+
+			MoveList moves = {moveBuffer11, 0};
+			map11.generateMoves(turn11, true, moves);
+			if(moves.count>0)
+			{
+				Move& move = moves.moves[(7*madeMoves)%moves.count];
+				map11.makeMove(move.cell, move.player, move.choice, true, captures11, undo11);
+			}
+			turn11 = map11.getNextPlayer(turn11);
+		}
+	}
+	setConsiderOverrideStones(true);
+
+	if(!error)
+	{
+		cout << "Test 11 passed!!!" << endl;
+	}
+	//END OF TEST 10
 
 	cout<<endl;
 	if(!error)	// no errors found
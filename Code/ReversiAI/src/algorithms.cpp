@@ -3,115 +3,429 @@
 // At the moment there are 2 algorithm implemented, minimax and alphabeta
 // pruning, both with paranoid search. For alpha beta pruning there is the
 // option to use a move sorting and an aspiration window optimization.
+// The move sorting can also search as a principal variation search,
+// or merge the opponents that hardly interact with us into a single ply.
+// The move sorting can also be run on several threads (lazy SMP), which
+// share their results through the transposition table. For a fixed search
+// depth alphabeta can be split over a work stealing thread pool instead,
+// which searches the younger brothers of a node once its eldest is done.
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
 #include <time.h>
-#include <sys/time.h>
 #include <cmath>
-#include <signal.h>
 #include <string.h>
 #include <list>
 #include <iterator>
 #include <atomic>
 #include <climits>
-#include <map>
+#include <algorithm>
+#include <thread>
+#include <random>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <future>
+#include <functional>
 #include <stdint.h>
 #include "algorithms.h"
 #include "map.h"
+#include "transposition.h"
+#include "workstealing.h"
+#include "timemanager.h"
 
 using namespace std;
 
-// Variables for benchmarking tests
-struct timespec spec;
-long timeSpendEvaluating=0;
-long startTime,endTime;
-int nodesAnalyzed = 0;
+// The search used by getNextMove() and the other functions which do not take a context
+SearchContext defaultSearch;
 
-// Variables for the AI
-Move bestMove;
+// The amount of checks of the stop flag after which the clock is compared with the deadline of the search
+#define TIME_CHECK_INTERVAL 512
 
-double const windowSize = 5; // in percentage
-double const windowResize = 20; // half of percentage as we are resizing in both directions
-bool wasWindowSuccesfull=false;
+// The depth up to which the positions are searched while pondering, deeper iterations would not finish during a turn
+#define MAX_PONDER_DEPTH 30
 
-int currentChoice=0;
-int currentCell=0;
+// The minimal depth of a node for PARALLEL_ALPHABETA to search its moves in parallel, smaller subtrees are not worth a task
+#define MIN_SPLIT_DEPTH 2
 
-int numberOfPlayers;
-int initialDepth=0;
-int playerID =0;
-long searchTime;
-long searchStart;
-long currentTime;
-int nextPlayer=0;
+// The ratings of the move ordering for the move of the transposition table and the first killer move, the second
+// killer move is rated one less. The history of a move is halved for all moves once it exceeds HISTORY_LIMIT.
+#define TRANSPOSITION_MOVE_RATING UINT32_MAX
+#define KILLER_MOVE_RATING (UINT32_MAX-1)
+#define HISTORY_LIMIT (1u<<30)
 
-static volatile sig_atomic_t hasTimePassed, hasHalfTimePassed;
+// Added to the hash keys of the positions searched by BEST_REPLY, as it rates them other than the paranoid search,
+// the first one for the positions in which we move and the second one for those in which the opponents reply
+#define BEST_REPLY_KEY 0xD6E8FEB86659FD93ULL
+#define BEST_REPLIES_KEY 0x8EBC6AF09C88C6E3ULL
 
-int nodeCount;
-int lastNodeCount;
-int branchingFactor=15;
-int breakCount=0;
-int successCount=0;
+// Multiplied with the set of the merged opponents and added to the hash keys of the positions searched by
+// OPPONENT_COALESCING, as the merged ply changes the moves that follow a position
+#define COALESCING_KEY 0xA24BAED4963EE407ULL
 
-struct sigaction sa;
-struct itimerval timer;
+/**
+ * A node of PARALLEL_ALPHABETA whose younger brothers are searched by the thread pool, after its eldest child.
+ * The window and the best move of the node are shared by all threads searching one of its moves.
+ */
+typedef struct SplitPoint
+{
+	SplitPoint* parent;			///< The split point of the closest ancestor that has been split, NULL if there is none
+	SearchContext* mainSearch;	///< The search whose pool searches the moves, it provides the contexts of the threads
+	Map* map;					///< Copy of the position of the node, from which stolen moves are made
+	Move* moves;
+	uint8_t turn;
+	int depth;
+	bool isPlayingPhase;
+	bool isRoot;
+
+	mutex lock;					///< Guards the window and the best move
+	int64_t alpha;
+	int64_t beta;
+	int64_t best;
+	int bestIndex;
+
+	atomic<int> pendingMoves;	///< The moves whose search has not finished yet
+	atomic<bool> isCutOff;		///< Set once a move caused a cutoff, which stops the searches of the other moves
+} SplitPoint;
+
+void sortTranspositionMove(MoveList& moves, TranspositionEntry& entry);
+static inline int64_t lowerWindowBound(int64_t value, int64_t margin);
+static inline int64_t upperWindowBound(int64_t value, int64_t margin);
+static inline void selectMove(MoveList& moves, uint32_t* ratings, int m);
+
+/**
+ * Compares two moves of the root for their order, see SearchContext::sortRootMoves().
+ */
+static bool isRootMoveBetter(const RootMove& first, const RootMove& second)
+{
+	return first.score>second.score || (first.score==second.score && first.nodes>second.nodes);
+}
+
+/**
+ * Checks whether an algorithm searches without override stones as long as there are other moves,
+ * which reduces the branching factor. Searches and analyses done for that algorithm have to follow it.
+ *
+ * @param algorithm - The identifier of the algorithm
+ * @return True if override stones are only considered if there is no other move, false if they are always considered
+ */
+static bool isSkippingOverrideStones(int algorithm)
+{
+	return algorithm==ALPHABETA_MOVESORTING || algorithm==LAZY_SMP || algorithm==PRINCIPAL_VARIATION
+		|| algorithm==ASPIRATIONAL_WINDOW || algorithm==BEST_REPLY || algorithm==OPPONENT_COALESCING;
+}
+
+/**
+ * Checks whether an algorithm searches the paranoid tree of the move sorting, in which the considered players move one
+ * after another. The pondering for these algorithms has to search the same tree, as it shares the transposition table.
+ *
+ * @param algorithm - The identifier of the algorithm
+ * @return True if the algorithm searches with moveSorting() over the considered players, false otherwise
+ */
+static bool isSearchingConsideredPlayers(int algorithm)
+{
+	return algorithm==ALPHABETA_MOVESORTING || algorithm==LAZY_SMP || algorithm==PRINCIPAL_VARIATION
+		|| algorithm==ASPIRATIONAL_WINDOW;
+}
+
+/**
+ * Checks whether a player is one of the players considered by the search, see Map::initializeNeighbourList().
+ *
+ * @param map - The map whose considered players are checked
+ * @param root - A considered player, e.g. the player the search is done for
+ * @param player - The player that is checked
+ * @return True if the player is considered, false otherwise
+ */
+static bool isConsideredPlayer(Map& map, uint8_t root, uint8_t player)
+{
+	uint8_t p=root;
+	for(int i=0; i<map.getAmountOfConsideredPlayers(); ++i)
+	{
+		if(p==player)
+		{
+			return true;
+		}
+		p=map.getNextPlayer(p);
+	}
+	return false;
+}
+
+/**
+ * Creates a search context with the default settings, which can search any amount of moves one after another.
+ */
+SearchContext::SearchContext()
+{
+	hasTimePassed=false;
+	timeCheckCount=0;
+	deadline=chrono::steady_clock::time_point::max();
+
+	Move noMove = {0, 0, 0, 0, 0};
+	result.move=noMove;
+	result.score=0;
+	result.depth=0;
+	result.nodesAnalyzed=0;
+	result.timeSpendEvaluating=0;
+	result.tableProbes=0;
+	result.tableHits=0;
+	result.tableCollisions=0;
+	result.deadlineOvershoot=0;
+
+	WindowStatistics noWindows = {0, 0, 0, 0, 0, 0, 0};
+	result.window=noWindows;
+	gameWindows=noWindows;
+	windowSize=DEFAULT_WINDOW_SIZE;
+	windowResize=DEFAULT_WINDOW_RESIZE;
+
+	result.cutoffs=0;
+	result.firstMoveCutoffs=0;
+	for(int ply=0; ply<MAX_KILLER_PLY; ++ply)
+	{
+		killerMoves[ply][0]=noMove;
+		killerMoves[ply][1]=noMove;
+	}
+	cutoffCount=0;
+	firstMoveCutoffCount=0;
+
+	timeSpendEvaluating=0;
+	startTime=0;
+	endTime=0;
+	nodesAnalyzed=0;
+
+	currentChoice=0;
+	currentCell=0;
+	initialDepth=0;
+	nextPlayer=0;
+	score=0;
+	numberOfRepeatings=0;
+
+	numberOfPlayers=0;
+	playerID=0;
+
+	iterationStartNodes=0;
+
+	threadCount = max(1u, thread::hardware_concurrency());
+	mainSearch=this;
+	areHelpersStopped=false;
+	helperNodesAnalyzed=0;
+
+	table=&transpositionTable;
+	rootPlayerKey=0;
+
+	isScouting=false;
+	isBestReply=false;
+	opponentCount=0;
+	isCoalescing=false;
+	coalescedCount=0;
+	coalescingDepth=DEFAULT_COALESCING_DEPTH;
+	isConsideringOverrideStones=true;
+	splitMapCount=0;
+}
+
+/**
+ * Stops the threads of the context, before the contexts they use are freed.
+ */
+SearchContext::~SearchContext()
+{
+	searchPool.reset();
+}
+
+/**
+ * Sets the player for whom the positions are rated. The ratings depend on that player, so the player
+ * is part of the keys of the transposition table.
+ *
+ * @param player - The player we search for
+ */
+void SearchContext::setRootPlayer(uint8_t player)
+{
+	playerID = player;
+	rootPlayerKey = player*0x9E3779B97F4A7C15ULL;
+}
+
+/**
+ * Creates the threads of PARALLEL_ALPHABETA, unless the pool of the context already has the wanted size.
+ */
+void SearchContext::startSearchPool()
+{
+	if(!searchPool || searchPool->getThreadCount()!=threadCount)
+	{
+		searchPool.reset(new WorkStealingPool());
+		searchPool->start(threadCount);
+	}
+}
+
+/**
+ * Prepares a context to help the search of another one. It searches for the same player with the table of the other context.
+ *
+ * @param main - The context whose search is helped
+ */
+void SearchContext::startHelping(SearchContext& main)
+{
+	mainSearch=&main;
+	table=main.table;
+	rootPlayerKey=main.rootPlayerKey;
+	playerID=main.playerID;
+	numberOfPlayers=main.numberOfPlayers;
+	initialDepth=0;
+	nodesAnalyzed=0;
+	captureBuffer.resize(main.captureBuffer.size());
+
+	// The helper starts with the history of the main context, but finds its own killer moves
+	history=main.history;
+	Move noMove = {0, 0, 0, 0, 0};
+	for(int ply=0; ply<MAX_KILLER_PLY; ++ply)
+	{
+		killerMoves[ply][0]=noMove;
+		killerMoves[ply][1]=noMove;
+	}
+}
+
+/**
+ * Starts the time measurement of the search of this context and sets its deadline.
+ *
+ * @param map - The position that is searched
+ * @param isPlayingPhase - Set if we are in the playing phase, unset for the bombing phase
+ * @param searchTime - The time limit of the search in ms, a negative value if the search has no deadline
+ */
+void SearchContext::setDeadline(Map& map, bool isPlayingPhase, int searchTime)
+{
+	timeManager.startSearch(map, isPlayingPhase, searchTime);
+	deadline = timeManager.getDeadline();
+	timeCheckCount = 0;
+}
 
-int64_t score;
+/**
+ * Starts the measurement of the next iteration of the search, for the prediction of the time manager.
+ */
+void SearchContext::startIteration()
+{
+	iterationStartNodes = nodesAnalyzed+helperNodesAnalyzed;
+	timeManager.startIteration();
+}
 
-void setBestMove();
-void updateBestMove(uint16_t cell, char choice, int64_t* best);
-int64_t moveSorting_firstIte(Map& map, uint8_t turn, multimap<int,int>* nextMoves, bool isPlayingPhase);
-int64_t moveSorting(Map& map, uint8_t player, int currentDepth, int64_t alpha, int64_t beta, multimap<int,int>* curMoves, multimap<int,int>* nextMoves, bool isPlayingPhase);
-int64_t alphabeta(Map& map, uint8_t turn, int depth, bool isPlayingPhase, int64_t alpha, int64_t beta);
-int64_t minimax(Map& map, uint8_t turn, int depth, bool isPlayingPhase);
-void startTimer();
-void endTimer();
+/**
+ * Passes the nodes and the time of an iteration that was searched completely to the time manager.
+ *
+ * @param depth - The search depth of the iteration
+ */
+void SearchContext::finishIteration(int depth)
+{
+	timeManager.finishIteration(depth, nodesAnalyzed+helperNodesAnalyzed-iterationStartNodes);
+}
 
 /**
- * The callback function that gets called if a signal is send.
+ * Passes the nodes of an iteration that was stopped by the deadline to the time manager.
  *
- * @param signum - The type of signal that initiated the callback function. We only use this function to handle the timers signal
+ * @param depth - The search depth of the iteration
+ */
+void SearchContext::abortIteration(int depth)
+{
+	timeManager.abortIteration(depth, nodesAnalyzed+helperNodesAnalyzed-iterationStartNodes);
+}
+
+/**
+ * Asks the running search of this context to return the best move found so far as soon as possible.
+ * Unlike the other methods it can be called from any thread, e.g. while waiting for the future of searchAsync().
+ */
+void SearchContext::stop()
+{
+	hasTimePassed = true;
+}
+
+/**
+ * Returns whether the search has to return, as its deadline has passed or as it got stopped.
+ * The clock is only read every TIME_CHECK_INTERVAL calls, so the check can be done at every node.
+ */
+inline bool SearchContext::hasTimeRunOut()
+{
+	if(++timeCheckCount>=TIME_CHECK_INTERVAL)
+	{
+		timeCheckCount=0;
+		if(chrono::steady_clock::now()>=mainSearch->deadline && !mainSearch->hasTimePassed.exchange(true))
+		{
+			cout << "G3-Timer: Time has run out, returning the currently best move." << endl;
+		}
+	}
+	return mainSearch->hasTimePassed.load(memory_order_relaxed);
+}
+
+/**
+ * Returns whether the next iterative deepening iteration is started, which is the case
+ * if the time manager predicts that it finishes before the deadline and the search was not stopped.
  */
-void timerHandler(int signum)
+bool SearchContext::isNextIterationAffordable()
 {
-	// Set the first flag after the first call
-	if(!hasHalfTimePassed)
+	if(hasTimePassed)
 	{
-		cout << "G3-Timer: First timer signal has been send, not starting the next iterative deepening iteration." << endl;
-		hasHalfTimePassed=true;
+		return false;
 	}
-	else // if the first flag is set already, set the second one
+	if(!timeManager.isNextIterationAffordable())
 	{
-		cout << "G3-Timer: Time has run out, returning the currently best move." << endl;
-		hasTimePassed=true;
+		cout << "G3-Timer: Predicted time of the next iteration is not left, not starting the next iterative deepening iteration." << endl;
+		return false;
 	}
+	return true;
+}
+
+/**
+ * Sets the memory used by the transposition table. All positions stored so far are lost.
+ * If it is not called, the table is allocated with DEFAULT_TABLE_SIZE MB by the first search.
+ *
+ * @param megabytes - The size of the table in MB
+ */
+void SearchContext::setTranspositionTableSize(int megabytes)
+{
+	transpositionTable.resize(megabytes);
+}
+
+/**
+ * Sets the amount of threads LAZY_SMP and PARALLEL_ALPHABETA search with. By default one thread is used for every core.
+ *
+ * @param threads - The amount of threads, including the main thread, at least one thread is used
+ */
+void SearchContext::setThreadCount(int threads)
+{
+	threadCount = max(1, threads);
 }
 
 /**
- * Initialise the callback function for the timer. Call this method before expecting a search time limit to work.
+ * Sets the half width of the first aspiration window of ASPIRATIONAL_WINDOW. By default it is DEFAULT_WINDOW_SIZE.
+ *
+ * @param size - The half width in percentage of the cells of the map
  */
-void initTimer()
+void SearchContext::setWindowSize(double size)
 {
-	/* Install timer_handler as the signal handler for SIGVTALRM. */
+	windowSize = size;
+}
 
-	memset (&sa, 0, sizeof (sa));
-	sa.sa_handler = &timerHandler;
-	sigaction (SIGALRM, &sa, 0);	// sets the function timer_handler to be executed once the timer triggers
+/**
+ * Sets the depth below which OPPONENT_COALESCING skips the ply of the merged opponents.
+ *
+ * @param depth - The plies that have to be left for the merged ply to be searched
+ */
+void SearchContext::setCoalescingDepth(int depth)
+{
+	coalescingDepth = depth;
+}
 
-	timer.it_value.tv_sec = 0;
-	timer.it_value.tv_usec = 0;
-	timer.it_interval.tv_sec = 0;
-	timer.it_interval.tv_usec = 0;
+/**
+ * Returns whether the search has to stop, either as the time has run out
+ * or as the main context finished its search if this is a helper of LAZY_SMP.
+ */
+inline bool SearchContext::isSearchStopped()
+{
+	return hasTimeRunOut() || mainSearch->areHelpersStopped.load(memory_order_relaxed);
 }
 
 /**
- * At the moment only used to display the amount of failed and successful time predictions.
+ * Displays the amount of searches that hit their deadline and of those that returned in time,
+ * as well as the average depth reached.
  */
-void close(){
-	cout << "Failures: "<<breakCount <<endl;
-	cout << "Success: "<<successCount<<endl;
+void SearchContext::close(){
+	timeManager.report();
+	if(gameWindows.iterations>0)
+	{
+		reportWindows(gameWindows);
+	}
 }
 
 /**
@@ -125,9 +439,9 @@ void close(){
  * @param algorithm - The identifier for the algorithm that should be used
  * @param isPlayeringPhase - Used to distinguish between playing and bombing phase
  *
- * @return A pointer to the move identified as the best move.
+ * @return The result of the search, which stays valid until the next search of this context
  */
-Move* getNextMove(Map& map, int searchDepth, int searchTime, uint8_t player, int algorithm, bool isPlayingPhase)
+SearchResult& SearchContext::search(Map& map, int searchDepth, int searchTime, uint8_t player, int algorithm, bool isPlayingPhase)
 {
 	if(searchDepth==0)
 	{
@@ -139,444 +453,904 @@ Move* getNextMove(Map& map, int searchDepth, int searchTime, uint8_t player, int
 		searchTime = 120000; // Default timeout timer, in case a search depth is specified
 	}
 
-	hasHalfTimePassed = false;
 	hasTimePassed = false;
+	areHelpersStopped = false;
 
-#ifndef BENCHMARK // disable the timer for benchmarking, as otherwise it will fire after 120 seconds
-
-	int timeBeforeConsideringToStop = (int)((1.0/branchingFactor)*searchTime);
+#ifndef BENCHMARK
+	setDeadline(map, isPlayingPhase, max(0, searchTime));
+#else // no deadline for benchmarking, as otherwise it would stop deep searches after 120 seconds
+	setDeadline(map, isPlayingPhase, -1);
+#endif
 
-	timer.it_value.tv_sec = timeBeforeConsideringToStop/1000;
-	timer.it_value.tv_usec = (timeBeforeConsideringToStop%1000)*1000;
-	timer.it_interval.tv_sec = (searchTime-timeBeforeConsideringToStop)/1000;
-	timer.it_interval.tv_usec = ((searchTime-timeBeforeConsideringToStop)%1000)*1000;
-	setitimer (ITIMER_REAL, &timer, 0);
+	captureBuffer.resize(map.getMaximumCaptureCount());
+	startMoveOrdering(map);
 
-#endif
+	setRootPlayer(player);
+	isScouting = algorithm==PRINCIPAL_VARIATION;
+	isBestReply = algorithm==BEST_REPLY;
+	isCoalescing = algorithm==OPPONENT_COALESCING;
+	result.move.player=player;
+	result.depth=0;
 
-	nodeCount=0;
+	WindowStatistics noWindows = {0, 0, 0, 0, 0, 0, 0};
+	result.window=noWindows;
 
-	playerID = player;
-	bestMove.player=player;
+	table->startSearch();
 
 	int currentDepth=1;
-	numberOfPlayers = getAmountOfPlayers();
+	numberOfPlayers = map.getAmountOfPlayers();
 
 	if(algorithm==MINIMAX)
 	{
-		while(currentDepth<=searchDepth && !hasHalfTimePassed)
+		while(currentDepth<=searchDepth && isNextIterationAffordable())
 		{
 			cout << "Searching with search depth "<<currentDepth<<endl;
 			initialDepth=currentDepth;
 
 			// Execute minimax with the current depth limit
-			minimax(map, player, currentDepth, isPlayingPhase);
+			startIteration();
+			int64_t value = minimax(map, player, currentDepth, isPlayingPhase);
 			if(hasTimePassed)
 			{
+				abortIteration(currentDepth);
 				break;
 			}
+			finishIteration(currentDepth);
 
 			// Save the best move found at that iteration
-			setBestMove();
+			setBestMove(map, currentDepth, value);
 
 			currentDepth++;
 		}
 	}
 	else if(algorithm==ALPHABETA)
 	{
-		while(currentDepth<=searchDepth && !hasHalfTimePassed)
+		while(currentDepth<=searchDepth && isNextIterationAffordable())
 		{
 			cout << "Searching with tree depth "<<currentDepth << endl;
 			initialDepth=currentDepth;
 
 			// Execute alphabeta with the current depth limit
-			alphabeta(map, player, currentDepth, isPlayingPhase, INT64_MIN, INT64_MAX);
+			startIteration();
+			int64_t value = alphabeta(map, player, currentDepth, isPlayingPhase, INT64_MIN, INT64_MAX);
+			if(hasTimePassed)
+			{
+				abortIteration(currentDepth);
+				break;
+			}
+			finishIteration(currentDepth);
+
+			// Save the best move found at that iteration
+			setBestMove(map, currentDepth, value);
+
+			currentDepth++;
+		}
+	}
+	else if(algorithm==PARALLEL_ALPHABETA)
+	{
+		startSearchPool();
+
+		// Every thread of the pool except for this one searches with its own context
+		workerSearches.resize(threadCount);
+		for(int i=1; i<threadCount; ++i)
+		{
+			if(!workerSearches[i])
+			{
+				workerSearches[i].reset(new SearchContext());
+			}
+			workerSearches[i]->startHelping(*this);
+		}
+
+		isConsideringOverrideStones = getConsiderOverrideStones();
+		helperNodesAnalyzed = 0;
+		searchPool->activate();
+
+		while(currentDepth<=searchDepth && isNextIterationAffordable())
+		{
+			cout << "Searching with tree depth "<<currentDepth << endl;
+			initialDepth=currentDepth;
+
+			// Execute the parallel alphabeta with the current depth limit
+			startIteration();
+			int64_t value = parallelAlphabeta(map, player, currentDepth, isPlayingPhase, INT64_MIN, INT64_MAX, 0, NULL);
 			if(hasTimePassed)
 			{
+				abortIteration(currentDepth);
 				break;
 			}
+			finishIteration(currentDepth);
 
 			// Save the best move found at that iteration
-			setBestMove();
+			setBestMove(map, currentDepth, value);
 
 			currentDepth++;
 		}
+
+		searchPool->deactivate();
+
+		if(threadCount>1)
+		{
+			cout << "Nodes analysed by "<<threadCount-1<<" pool threads: "<<helperNodesAnalyzed<<endl;
+		}
 	}
-	else if(algorithm==ALPHABETA_MOVESORTING)
+	else if(algorithm==ALPHABETA_MOVESORTING || algorithm==LAZY_SMP || algorithm==PRINCIPAL_VARIATION || algorithm==OPPONENT_COALESCING)
 	{
-		multimap<int,int> curMoves;
-		multimap<int,int> nextMoves;
+		vector<RootMove> rootMoves;
+
+		if(isCoalescing)
+		{
+			coalesceOpponents(map, player, isPlayingPhase);
+		}
+
+		vector<thread> helpers;
+		vector<unique_ptr<SearchContext> > helperSearches;
+		vector<Map> helperMaps;
 
 		cout << "Searching with tree depth 1"<<endl;
-		nodeCount=0;
+		startIteration();
 
-		setConsiderOverrideStones(false);
-		int score = moveSorting_firstIte(map, player, &curMoves, isPlayingPhase);
-		if(curMoves.empty())
+		setConsiderOverrideStones(!isSkippingOverrideStones(algorithm));
+		int64_t score = moveSorting_firstIte(map, player, rootMoves, isPlayingPhase);
+		if(rootMoves.empty())
 		{
 			setConsiderOverrideStones(true);
-			score = moveSorting_firstIte(map, player, &curMoves, isPlayingPhase);
+			score = moveSorting_firstIte(map, player, rootMoves, isPlayingPhase);
 		}
 
-		lastNodeCount=nodeCount;
+		finishIteration(1);
 
 		// Save the move the of the first iteration
-		setBestMove();
+		setBestMove(map, 1, score);
 
 		currentDepth++;
 
-		while(currentDepth<=searchDepth && !hasHalfTimePassed && (score>INT64_MIN+MAX_PLAYER) && (score<INT64_MAX-MAX_PLAYER))
+		// Start the helpers once it is known whether override stones are considered. Every helper gets its
+		// own copy of the map, which has to be made before the main thread starts changing the map.
+		if(algorithm==LAZY_SMP && threadCount>1 && currentDepth<=searchDepth)
+		{
+			helperNodesAnalyzed = 0;
+			helperMaps.resize(threadCount-1);
+			for(int i=0; i<threadCount-1; ++i)
+			{
+				helperMaps[i].copy(map);
+				helperSearches.push_back(unique_ptr<SearchContext>(new SearchContext()));
+				helperSearches[i]->startHelping(*this);
+				helpers.push_back(thread(&SearchContext::searchAsHelper, helperSearches[i].get(), &helperMaps[i], i, searchDepth, player, isPlayingPhase, getConsiderOverrideStones(), rootMoves));
+			}
+		}
+
+		while(currentDepth<=searchDepth && isNextIterationAffordable() && (score>INT64_MIN+MAX_PLAYER) && (score<INT64_MAX-MAX_PLAYER))
 		{
 
 			cout << "Searching with tree depth "<<currentDepth << endl;
 			initialDepth=currentDepth;
-			nodesAnalyzed=0;
+			startIteration();
 
-			moveSorting(map, player, currentDepth, INT64_MIN, INT64_MAX, &curMoves, &nextMoves, isPlayingPhase);
+			int64_t value = moveSorting(map, player, currentDepth, INT64_MIN, INT64_MAX, &rootMoves, isPlayingPhase);
 			if(hasTimePassed)
 			{
+				abortIteration(currentDepth);
 				break;
 			}
-
-			nodeCount+=nodesAnalyzed;
-			lastNodeCount=nodesAnalyzed;
+			finishIteration(currentDepth);
 
 			// Save the best move found at that iteration
 			if(isPlayingPhase || score>INT64_MAX-MAX_PLAYER || score<=INT64_MIN+MAX_PLAYER)
 			{
-				setBestMove();
+				setBestMove(map, currentDepth, value);
 			}
 
-			curMoves.swap(nextMoves);
-			nextMoves.clear();
+			sortRootMoves(rootMoves);
 
 			currentDepth++;
 		}
 
-		if(hasTimePassed)
-		{
-			breakCount++;
-		}
-		else
+		if(!helpers.empty())
 		{
-			successCount++;
-
-			if(currentDepth>2)
-			{
-				branchingFactor = (int)(log(lastNodeCount)/log(currentDepth-1));
-			}
-			else
+			areHelpersStopped = true;
+			for(size_t i=0; i<helpers.size(); ++i)
 			{
-				branchingFactor=lastNodeCount;
+				helpers[i].join();
 			}
 
-			// Add one as our predication seem to be a bit to tight(only 66% success)
-			branchingFactor+=2;
-
-			cout << "Branching Faktor: "<<branchingFactor <<endl;
+			cout << "Nodes analysed by "<<helpers.size()<<" helper threads: "<<helperNodesAnalyzed<<endl;
 		}
 	}
-	else if(algorithm==ASPIRATIONAL_WINDOW)
+	else if(algorithm==BEST_REPLY)
 	{
-		multimap<int,int> curMoves;
-		multimap<int,int> nextMoves;
+		vector<RootMove> rootMoves;
 
-		bool isSecondTry=false;
+		// The opponents who reply to our moves are the other players considered by the paranoid search
+		opponentCount=0;
+		for(uint8_t p=map.getNextPlayer(player); p!=player && opponentCount<map.getAmountOfConsideredPlayers(); p=map.getNextPlayer(p))
+		{
+			opponents[opponentCount++]=p;
+		}
 
 		cout << "Searching with tree depth 1"<<endl;
-		nodesAnalyzed=0;
-		int moveValue = moveSorting_firstIte(map, player, &curMoves, isPlayingPhase);
-		cout << "Value: "<< moveValue<<endl;
-		nodeCount+=nodesAnalyzed;
+		startIteration();
 
-		// Save the move the of the first iteration
-		setBestMove();
+		setConsiderOverrideStones(!isSkippingOverrideStones(algorithm));
+		int64_t value = moveSorting_firstIte(map, player, rootMoves, isPlayingPhase);
+		if(rootMoves.empty())
+		{
+			setConsiderOverrideStones(true);
+			value = moveSorting_firstIte(map, player, rootMoves, isPlayingPhase);
+		}
 
-		currentDepth++;
+		finishIteration(1);
 
-		int alpha=INT_MIN,beta=INT_MAX;
-		int lastScore=moveValue;
+		// Save the move the of the first iteration
+		setBestMove(map, 1, value);
 
-		alpha = moveValue - (windowSize*getAmountOfCells());
-		beta = moveValue + (windowSize*getAmountOfCells());
+		currentDepth++;
 
-		while(currentDepth<=searchDepth && !hasHalfTimePassed)
+		while(currentDepth<=searchDepth && isNextIterationAffordable())
 		{
-			cout << "Searching with tree depth "<<currentDepth << endl;
+			cout << "Searching with tree depth "<<currentDepth<<", "<<(currentDepth+1)/2<<" of our moves" << endl;
 			initialDepth=currentDepth;
-			nodesAnalyzed=0;
-			cout << "alpha: "<< alpha << "	beta: "<< beta << endl;
+			startIteration();
 
-			moveValue = moveSorting(map, player, currentDepth, INT_MIN, INT_MAX, &curMoves, &nextMoves, isPlayingPhase);
+			value = searchRoot(map, player, INT64_MIN, INT64_MAX, rootMoves, isPlayingPhase);
 			if(hasTimePassed)
 			{
+				abortIteration(currentDepth);
 				break;
 			}
-			nodeCount+=nodesAnalyzed;
+			finishIteration(currentDepth);
 
-			cout << "Value: "<< moveValue<<endl;
+			// Save the best move found at that iteration
+			setBestMove(map, currentDepth, value);
 
-			if(alpha<moveValue && moveValue<beta)
-			{
-				currentDepth++;
-				lastScore=moveValue;
+			sortRootMoves(rootMoves);
 
-				// Save the best move found at that iteration
-				setBestMove();
+			currentDepth++;
+		}
+	}
+	else if(algorithm==ASPIRATIONAL_WINDOW)
+	{
+		vector<RootMove> rootMoves;
+
+		cout << "Searching with tree depth 1"<<endl;
+		startIteration();
+
+		// Like the move sorting, override stones are only considered if there is no other move
+		setConsiderOverrideStones(!isSkippingOverrideStones(algorithm));
+		int64_t moveValue = moveSorting_firstIte(map, player, rootMoves, isPlayingPhase);
+		if(rootMoves.empty())
+		{
+			setConsiderOverrideStones(true);
+			moveValue = moveSorting_firstIte(map, player, rootMoves, isPlayingPhase);
+		}
+		cout << "Value: "<< moveValue<<endl;
+		finishIteration(1);
 
-				curMoves.swap(nextMoves);
-				nextMoves.clear();
+		// Save the move the of the first iteration
+		setBestMove(map, 1, moveValue);
+
+		currentDepth++;
 
-				isSecondTry=false;
+		// The half widths of the window tried first, of the one tried after it failed and of the last one, which is unbounded
+		int64_t margins[] = {(int64_t)(windowSize*map.getAmountOfCells()), (int64_t)(windowResize*map.getAmountOfCells()), INT64_MAX};
+		int64_t lastScore=moveValue;
 
-				alpha = moveValue - (windowSize*getAmountOfCells());
-				beta = moveValue + (windowSize*getAmountOfCells());
-			}
-			else if(!isSecondTry)
+		while(currentDepth<=searchDepth && isNextIterationAffordable())
+		{
+			cout << "Searching with tree depth "<<currentDepth << endl;
+			initialDepth=currentDepth;
+			startIteration();
+
+			int lowerTries=0, upperTries=0;
+			int64_t alpha = lowerWindowBound(lastScore, margins[0]);
+			int64_t beta = upperWindowBound(lastScore, margins[0]);
+
+			// Search again until the value lies inside the window, with the failed side widened around the bound that
+			// was found. The positions of the failed search are found in the transposition table with their best moves.
+			// At the root its values are only bounds, so the order of the former iteration is kept, except that a move
+			// which failed high is searched first.
+			while(true)
 			{
-				isSecondTry=true;
-				if(moveValue<=alpha)// fail low
+				cout << "alpha: "<< alpha << "	beta: "<< beta << endl;
+				uint64_t triedNodes = nodesAnalyzed;
+
+				moveValue = moveSorting(map, player, currentDepth, alpha, beta, &rootMoves, isPlayingPhase);
+				if(hasTimePassed)
+				{
+					break;
+				}
+				cout << "Value: "<< moveValue<<endl;
+
+				if(moveValue<=alpha && alpha>INT64_MIN) // fail low
+				{
+					result.window.failLows++;
+					result.window.failedNodes += nodesAnalyzed-triedNodes;
+					alpha = lowerWindowBound(moveValue, margins[++lowerTries]);
+				}
+				else if(moveValue>=beta && beta<INT64_MAX) // fail high
 				{
-					alpha = lastScore- windowResize*getAmountOfCells();
+					result.window.failHighs++;
+					result.window.failedNodes += nodesAnalyzed-triedNodes;
+					beta = upperWindowBound(moveValue, margins[++upperTries]);
+
+					// The best move of the root is the one that failed high
+					for(size_t r=0; r<rootMoves.size(); ++r)
+					{
+						if(rootMoves[r].move.cell==currentCell && rootMoves[r].move.choice==currentChoice)
+						{
+							rotate(rootMoves.begin(), rootMoves.begin()+r, rootMoves.begin()+r+1);
+							break;
+						}
+					}
 				}
-				else // fail high
+				else
 				{
-					beta = lastScore + windowResize*getAmountOfCells();
+					sortRootMoves(rootMoves);
+					break;
 				}
 			}
-			else
+
+			result.window.iterations++;
+			result.window.nodes += nodesAnalyzed-iterationStartNodes;
+
+			if(hasTimePassed)
 			{
-				alpha=INT_MIN;
-				beta=INT_MAX;
+				abortIteration(currentDepth);
+				break;
 			}
+			finishIteration(currentDepth);
+
+			// Save the best move found at that iteration
+			setBestMove(map, currentDepth, moveValue);
+			addScoreChange(map, lastScore, moveValue);
+
+			lastScore=moveValue;
+			currentDepth++;
 		}
-	}
 
-	//Cancel Timer
-	timer.it_value.tv_sec = 0;
-	timer.it_value.tv_usec = 0;
-	timer.it_interval.tv_sec = 0;
-	timer.it_interval.tv_usec = 0;
-	setitimer (ITIMER_REAL, &timer, 0);
+		reportWindows(result.window);
 
-	return &bestMove;
-}
+		gameWindows.iterations += result.window.iterations;
+		gameWindows.failLows += result.window.failLows;
+		gameWindows.failHighs += result.window.failHighs;
+		gameWindows.nodes += result.window.nodes;
+		gameWindows.failedNodes += result.window.failedNodes;
+		gameWindows.scoreChangeSum += result.window.scoreChangeSum;
+		gameWindows.scoreChanges += result.window.scoreChanges;
+	}
 
-/**
- * This function uses the data from the move searching algorithm and sets
- * the move that will be returned, if the timer run out, to the one found
- * by that algorithm.
- */
-void setBestMove()
-{
-	int x,y;
-	reverseOffset(&x, &y, currentCell);
-	bestMove.x=x;
-	bestMove.y=y;
-	bestMove.choice=currentChoice;
+	cout << "Transposition table: "<<table->getHitCount()<<" hits of "<<table->getProbeCount()
+		 <<" probes, "<<table->getCollisionCount()<<" collisions" << endl;
 
-	cout << "Current Best Move: ("<<bestMove.x<<", "<<bestMove.y<<", "<<(int)bestMove.choice<<")" << endl;
+	chrono::steady_clock::time_point returnTime = chrono::steady_clock::now();
+	result.deadlineOvershoot = 0;
+	if(returnTime>deadline)
+	{
+		result.deadlineOvershoot = chrono::duration_cast<chrono::microseconds>(returnTime-deadline).count();
+		cout << "G3-Timer: Returned "<<result.deadlineOvershoot<<" us after the deadline" << endl;
+	}
+	timeManager.finishSearch(result.depth);
+	isConsideringOverrideStones = getConsiderOverrideStones();
+
+	result.nodesAnalyzed=nodesAnalyzed+helperNodesAnalyzed;
+	result.timeSpendEvaluating=timeSpendEvaluating/1000000;
+	result.tableProbes=table->getProbeCount();
+	result.tableHits=table->getHitCount();
+	result.tableCollisions=table->getCollisionCount();
+	result.cutoffs=cutoffCount;
+	result.firstMoveCutoffs=firstMoveCutoffCount;
+	collectPrincipalVariation(map, player, isPlayingPhase);
+
+	return result;
 }
 
 /**
- * Updates the best move if it was better than the last one. This and the values for
- * score and best move are stored outside of the recursive function so we can use one function for all
- * the algorithms.
+ * Sets up the routine with which ponderDepth() searches for the given algorithm.
+ *
+ * @param map - The map that will be searched
+ * @param algorithm - The identifier of the algorithm that will search our next move
  */
-void updateBestMove(uint16_t cell, char choice, int64_t* best)
+void SearchContext::startPonderingRoutine(Map& map, int algorithm)
 {
-	if(score>=*best)
+	if(isSearchingConsideredPlayers(algorithm))
 	{
-		*best=score;
-		currentCell=cell;
-		currentChoice=choice;
+		startMoveOrdering(map);
+		isScouting = algorithm==PRINCIPAL_VARIATION;
+		isBestReply = false;
+		isCoalescing = false;
+		numberOfRepeatings = 0;
 	}
 }
 
 /**
- * Execute the first iteration of move sorting.
+ * Sets the turn order the search of the moves of the given player will use and finds the player to move after
+ * lastPlayer in it. The turn order is part of the keys of the transposition table, see Map::getHashKey().
  *
- * @param map - The inital state of the game
- * @param player - Identifies who can make the next move
- * @param nextMoves - A pointer to a list to store all possible moves, ordered by there expected value
- * @param isPlayingPhase - Used to distinguish between playing and bombing phase
+ * @param map - The map whose turn order is set
+ * @param lastPlayer - The player who made the last move
+ * @param player - The player whose moves will be searched
+ * @param algorithm - The identifier of the algorithm that will search the moves
+ * @param isPlayingPhase - Set if we are in the playing phase, unset for the bombing phase
+ * @return The player to move at the root of the pondering
  */
-int64_t moveSorting_firstIte(Map& map, uint8_t player, multimap<int,int>* nextMoves, bool isPlayingPhase)
+uint8_t SearchContext::prepareTurnOrder(Map& map, uint8_t lastPlayer, uint8_t player, int algorithm, bool isPlayingPhase)
 {
-	nodesAnalyzed++;
+	// The search of our move considers the neighbours of our player as well
+	if(isPlayingPhase)
+	{
+		map.initializeNeighbourList(player);
+	}
 
-	Map mapCopy;
-	mapCopy.copy(map);
+	uint8_t turn = getNextActivePlayer(map, lastPlayer);
+	if(isSearchingConsideredPlayers(algorithm))
+	{
+		while(!isConsideredPlayer(map, player, turn))
+		{
+			turn = getNextActivePlayer(map, turn);
+		}
+	}
+	return turn;
+}
 
-	int64_t best = INT64_MIN;
+/**
+ * Searches one depth of the pondering with the routine of the given algorithm: moveSorting() over the considered
+ * players or alphabeta() over all players. The root of the pondering is not the root of our search, so moveSorting()
+ * searches it like any inner node.
+ *
+ * @param map - The map that is searched
+ * @param turn - The player to move, see prepareTurnOrder()
+ * @param depth - The depth of the search
+ * @param algorithm - The identifier of the algorithm that will search our next move
+ * @param isPlayingPhase - Set if we are in the playing phase, unset for the bombing phase
+ */
+void SearchContext::ponderDepth(Map& map, uint8_t turn, int depth, int algorithm, bool isPlayingPhase)
+{
+	if(isSearchingConsideredPlayers(algorithm))
+	{
+		initialDepth=depth+1;
+		moveSorting(map, turn, depth, INT64_MIN, INT64_MAX, NULL, isPlayingPhase);
+	}
+	else
+	{
+		initialDepth=depth;
+		alphabeta(map, turn, depth, isPlayingPhase, INT64_MIN, INT64_MAX);
+	}
+}
 
-	if(isPlayingPhase)
+/**
+ * Searches the position of the game while the other players think about their moves, until stop() is called.
+ * The positions that follow the most likely replies, as assumed by the paranoid search, are rated for the given
+ * player and stored in the transposition table, where the search of our next move finds them again.
+ * The entries are only valid for a search of the same tree, so the pondering searches with the routine and the turn
+ * order of the given algorithm, see ponderDepth().
+ * It runs on the thread started by ponderAsync(), the search of the move has to wait until it has been stopped.
+ *
+ * @param map - The current state of the game, which is changed during the search
+ * @param lastPlayer - The player who made the last move, the next active player is the one to move
+ * @param player - The player for whom the positions are rated, which is the player we play for
+ * @param algorithm - The identifier of the algorithm that will search our next move
+ * @param isPlayingPhase - Set if we are in the playing phase, unset for the bombing phase
+ */
+void SearchContext::ponder(Map& map, uint8_t lastPlayer, uint8_t player, int algorithm, bool isPlayingPhase)
+{
+	deadline = chrono::steady_clock::time_point::max();
+	timeCheckCount = 0;
+
+	// Search the same moves as the last search, so that the positions are rated the same way
+	setConsiderOverrideStones(isConsideringOverrideStones);
+	captureBuffer.resize(map.getMaximumCaptureCount());
+
+	setRootPlayer(player);
+	table->startSearch();
+	numberOfPlayers = map.getAmountOfPlayers();
+
+	// The nodes of the pondering are not counted for the next search
+	uint64_t searchNodes = nodesAnalyzed;
+	nodesAnalyzed = 0;
+
+	startPonderingRoutine(map, algorithm);
+	uint8_t turn = prepareTurnOrder(map, lastPlayer, player, algorithm, isPlayingPhase);
+	int depth;
+	for(depth=1; depth<=MAX_PONDER_DEPTH && !hasTimePassed; ++depth)
 	{
-		char state;
+		ponderDepth(map, turn, depth, algorithm, isPlayingPhase);
+	}
+
+	cout << "G3-Ponder: Stopped in depth " << depth-1 << " after " << nodesAnalyzed << " nodes" << endl;
+	nodesAnalyzed = searchNodes;
+}
+
+/**
+ * Starts pondering on a thread of its own, which runs until stop() is called. See ponder() for the parameters.
+ *
+ * @return The future that is ready once the pondering has been stopped
+ */
+future<void> SearchContext::ponderAsync(Map& map, uint8_t lastPlayer, uint8_t player, int algorithm, bool isPlayingPhase)
+{
+	// Reset before the thread starts, so that a stop() right after this call is not lost
+	hasTimePassed = false;
+	areHelpersStopped = false;
+	return async(launch::async, &SearchContext::ponder, this, ref(map), lastPlayer, player, algorithm, isPlayingPhase);
+}
+
+/**
+ * Uses the time between the reception of the map and the first move request, in which our seat is not known yet.
+ * It searches the start position for every seat, one depth after another, until stop() is called. Every seat is
+ * searched with the routine and the turn order its own search would use, so that the entries are found again.
+ * Like pondering it runs on a thread of its own, which is started by analyseOpeningsAsync().
+ *
+ * @param map - The start position of the game, which is changed during the search
+ * @param algorithm - The identifier of the algorithm that will search our moves
+ * @param isPlayingPhase - Used to distinguish between playing and bombing phase
+ */
+void SearchContext::analyseOpenings(Map& map, int algorithm, bool isPlayingPhase)
+{
+	deadline = chrono::steady_clock::time_point::max();
+	timeCheckCount = 0;
 
-		for(int cell=0; cell<getAmountOfCells(); ++cell)
+	// Search the moves the algorithm will search, so that the positions are rated the same way
+	isConsideringOverrideStones = !isSkippingOverrideStones(algorithm);
+	setConsiderOverrideStones(isConsideringOverrideStones);
+	captureBuffer.resize(map.getMaximumCaptureCount());
+
+	table->startSearch();
+	if(algorithm==PARALLEL_ALPHABETA)
+	{
+		startSearchPool();
+	}
+	numberOfPlayers = map.getAmountOfPlayers();
+
+	uint64_t searchNodes = nodesAnalyzed;
+	nodesAnalyzed = 0;
+
+	startPonderingRoutine(map, algorithm);
+	int depth;
+	for(depth=1; depth<=MAX_PONDER_DEPTH && !hasTimePassed; ++depth)
+	{
+		for(uint8_t seat=1; seat<=numberOfPlayers && !hasTimePassed; ++seat)
 		{
-			if(hasTimePassed){
-				return 0;
-			}
-			state= map.getState(cell);
+			// The first move is made by player 1
+			setRootPlayer(seat);
+			uint8_t turn = prepareTurnOrder(map, numberOfPlayers, seat, algorithm, isPlayingPhase);
+			ponderDepth(map, turn, depth, algorithm, isPlayingPhase);
+		}
+	}
 
-			if(state=='b')
-			{
-				int64_t overrideScore;
+	cout << "G3-Ponder: Opening analysis stopped in depth " << depth-1 << " after " << nodesAnalyzed << " nodes" << endl;
+	nodesAnalyzed = searchNodes;
+}
 
-				if(mapCopy.isPlayingPhaseMoveValid(cell,player,20)) // If move is valid
-				{
-					nodesAnalyzed+=2; // We know that the 2 choices are valid
+/**
+ * Starts the opening analysis on a thread of its own, which runs until stop() is called.
+ * See analyseOpenings() for the parameters.
+ *
+ * @return The future that is ready once the analysis has been stopped
+ */
+future<void> SearchContext::analyseOpeningsAsync(Map& map, int algorithm, bool isPlayingPhase)
+{
+	hasTimePassed = false;
+	areHelpersStopped = false;
+	return async(launch::async, &SearchContext::analyseOpenings, this, ref(map), algorithm, isPlayingPhase);
+}
 
-#ifdef BENCHMARK
-					startTimer();
-#endif
+/**
+ * Starts search() on a thread of its own, so that the calling thread stays free while the move is searched,
+ * e.g. to read from the server. The search can be ended early with stop(). The map must not be used by the caller
+ * and no other search must be started with this context until the future is ready.
+ * See search() for the parameters.
+ *
+ * @return The future of the result of the search
+ */
+future<SearchResult&> SearchContext::searchAsync(Map& map, int searchDepth, int searchTime, uint8_t player, int algorithm, bool isPlayingPhase)
+{
+	return async(launch::async, &SearchContext::search, this, ref(map), searchDepth, searchTime, player, algorithm, isPlayingPhase);
+}
 
-					score=mapCopy.evaluateForPlayingPhase(playerID);
-					overrideScore=score;
-					if(hasTimePassed)
-					{
-						return 0;
-					}
+/**
+ * This function uses the data from the move searching algorithm and sets
+ * the move that will be returned, if the timer run out, to the one found
+ * by that algorithm.
+ *
+ * @param map   - The map on which the move was found
+ * @param depth - The depth of the iteration that found the move
+ * @param value - The value of the move found by the iteration
+ */
+void SearchContext::setBestMove(Map& map, int depth, int64_t value)
+{
+	int x,y;
+	map.reverseOffset(&x, &y, currentCell);
+	result.move.x=x;
+	result.move.y=y;
+	result.move.cell=currentCell;
+	result.move.choice=currentChoice;
+	result.score=value;
+	result.depth=depth;
+
+	cout << "Current Best Move: ("<<result.move.x<<", "<<result.move.y<<", "<<(int)result.move.choice<<")" << endl;
+}
 
-#ifdef BENCHMARK
-					endTimer();
-#endif
+/**
+ * Follows the best moves stored in the transposition table from the best move of the root, to find the moves
+ * the search expects to be played. The line ends at the depth of the search or at the first position whose
+ * best move is not known, so it only consists of the best move if the algorithm does not use the table.
+ *
+ * @param map - The initial state of the board, it is the same after the line has been followed
+ * @param player - The player who can make a move
+ * @param isPlayingPhase - Used to distinguish between playing and bombing phase
+ */
+void SearchContext::collectPrincipalVariation(Map& map, uint8_t player, bool isPlayingPhase)
+{
+	result.principalVariation.clear();
+	if(result.depth==0)
+	{
+		return;
+	}
 
-					updateBestMove(cell, 20, &best);
+	vector<UndoRecord> undo(result.depth);
+	Move moveBuffer[map.getMaximumMoveCount()];
+	MoveList moves = {moveBuffer, 0};
 
-					// reset the mapCopy state
-					mapCopy.copy(map);
-				}
+	Move move = result.move;
+	uint8_t turn = player;
 
-				if(mapCopy.isPlayingPhaseMoveValid(cell,player,21)) // If move is valid
-				{
-#ifdef BENCHMARK
-					startTimer();
-#endif
+	while(map.makeMove(move.cell, turn, move.choice, isPlayingPhase, captureBuffer.data(), undo[result.principalVariation.size()]))
+	{
+		result.principalVariation.push_back(move);
+		if((int)result.principalVariation.size()==result.depth)
+		{
+			break;
+		}
 
-					score=mapCopy.evaluateForPlayingPhase(playerID);
-					if(hasTimePassed){
-						return 0;
-					}
+		turn = getNextActivePlayer(map, turn);
 
-#ifdef BENCHMARK
-					endTimer();
-#endif
+		TranspositionEntry entry;
+		if(!table->probe(map.getHashKey(turn, isPlayingPhase) ^ rootPlayerKey, entry) || entry.cell==NO_CELL)
+		{
+			break;
+		}
 
-					// Insert the move to the list of possible move, such that the highest score is chosen as key
-					if(overrideScore>score)
-					{
-						nextMoves->insert(pair<int,int>(overrideScore,cell));
-					}
-					else
-					{
-						nextMoves->insert(pair<int,int>(score,cell));
-					}
+		// Only follow moves that are legal, as the entry might belong to another position with the same key
+		moves.count=0;
+		map.generateMoves(turn, isPlayingPhase, moves);
+		int m=0;
+		while(m<moves.count && (moves.moves[m].cell!=entry.cell || moves.moves[m].choice!=entry.choice))
+		{
+			m++;
+		}
+		if(m==moves.count)
+		{
+			break;
+		}
+		move = moves.moves[m];
+	}
 
-					updateBestMove(cell, 21, &best);
+	for(int i=(int)result.principalVariation.size()-1; i>=0; --i)
+	{
+		map.unmakeMove(undo[i]);
+	}
+}
 
-					// reset the mapCopy state
-					mapCopy.copy(map);
-				}
-			}
-			else if(state=='c')
-			{
-				// use int min to identify the
-				int64_t max = INT64_MIN;
+/**
+ * Returns the lower end of an aspiration window, which is INT64_MIN if the window is unbounded or reaches beyond it.
+ *
+ * @param value - The value the window is placed around
+ * @param margin - The distance of the end from the value, INT64_MAX for an unbounded window
+ */
+static inline int64_t lowerWindowBound(int64_t value, int64_t margin)
+{
+	return (margin<INT64_MAX && value>INT64_MIN+margin) ? value-margin : INT64_MIN;
+}
 
-				for(int p=1; p<=getAmountOfPlayers(); ++p)
-				{
-					if(mapCopy.isPlayingPhaseMoveValid(cell, player, p)) // If move is valid
-					{
-						nodesAnalyzed++;
-#ifdef BENCHMARK
-						startTimer();
-#endif
+/**
+ * Returns the upper end of an aspiration window, which is INT64_MAX if the window is unbounded or reaches beyond it.
+ *
+ * @param value - The value the window is placed around
+ * @param margin - The distance of the end from the value, INT64_MAX for an unbounded window
+ */
+static inline int64_t upperWindowBound(int64_t value, int64_t margin)
+{
+	return (margin<INT64_MAX && value<INT64_MAX-margin) ? value+margin : INT64_MAX;
+}
 
-						score=mapCopy.evaluateForPlayingPhase(playerID);
-						if(hasTimePassed){
-							return 0;
-						}
+/**
+ * Adds the change of the value between two iterations to the window statistics of the search, in the unit of the
+ * window sizes. Values of the end of the game are left out, as no window is meant to cover them.
+ *
+ * @param map - The initial state of the game
+ * @param lastScore - The value of the former iteration
+ * @param value - The value of the current iteration
+ */
+void SearchContext::addScoreChange(Map& map, int64_t lastScore, int64_t value)
+{
+	if(lastScore<=INT_MIN+MAX_PLAYER || lastScore>=INT_MAX-MAX_PLAYER || value<=INT_MIN+MAX_PLAYER || value>=INT_MAX-MAX_PLAYER)
+	{
+		return;
+	}
 
-#ifdef BENCHMARK
-						endTimer();
-#endif
+	result.window.scoreChangeSum += fabs((double)(value-lastScore))/map.getAmountOfCells();
+	result.window.scoreChanges++;
+}
 
-						if(score>max){
-							max=score;
-						}
+/**
+ * Displays how often the aspiration windows failed, the nodes spend on the failed searches and the average change
+ * of the value between two iterations, which should be covered by the first window most of the time.
+ *
+ * @param windows - The statistics of a search or of the whole game
+ */
+void SearchContext::reportWindows(WindowStatistics& windows)
+{
+	cout << "Aspiration windows: "<<windows.iterations<<" iterations, "<<windows.failLows<<" failed low, "
+		 <<windows.failHighs<<" failed high, "<<windows.failedNodes<<" of "<<windows.nodes<<" nodes in failed searches" << endl;
+	if(windows.scoreChanges>0)
+	{
+		cout << "Average change of the value: "<<windows.scoreChangeSum/windows.scoreChanges<<", window size: "<<windowSize << endl;
+	}
+}
 
-						updateBestMove(cell, p, &best);
+/**
+ * Updates the best move if it was better than the last one. This and the values for
+ * score and best move are stored outside of the recursive function so we can use one function for all
+ * the algorithms.
+ */
+void SearchContext::updateBestMove(uint16_t cell, char choice, int64_t* best)
+{
+	if(score>=*best)
+	{
+		*best=score;
+		currentCell=cell;
+		currentChoice=choice;
+	}
+}
 
-						mapCopy.copy(map);
-					}
-				}
-				if(max!=INT64_MIN)
-				{
-					nextMoves->insert(pair<int,int>(max,cell));
-				}
-			}
-			else // normal cell
-			{
-				if(mapCopy.isPlayingPhaseMoveValid(cell,player,0)) // If move is valid
-				{
-					nodesAnalyzed++;
-#ifdef BENCHMARK
-					startTimer();
-#endif
+/**
+ * Orders the moves of the root by the values of the last iteration, the best one first. Moves with the same value
+ * are ordered by the nodes of their subtrees, as a move that is hard to refute is likely to be better, and keep
+ * their former order if these are the same as well.
+ *
+ * @param rootMoves - The moves of the root
+ */
+void SearchContext::sortRootMoves(vector<RootMove>& rootMoves)
+{
+	stable_sort(rootMoves.begin(), rootMoves.end(), isRootMoveBetter);
+}
 
-					score=mapCopy.evaluateForPlayingPhase(playerID);
-					if(hasTimePassed){
-						return 0;
-					}
+/**
+ * Decides which opponents OPPONENT_COALESCING merges into the ply of COALESCED_PLAYER, in which the strongest move of
+ * any of them is made. The interaction of an opponent is the amount of our stones it touches plus the lines it shares
+ * with us, an opponent is merged if it interacts weakly: it is more than COALESCING_DISTANCE steps away from our stones,
+ * or its interaction is below COALESCING_SHARE percent of the one of the opponent interacting most, e.g. as it only
+ * touches us at a far edge. The merged ply takes the place of the first merged opponent in the turn order, the other
+ * opponents keep their own plies. The rule and the players it merges are reported. In the bombing phase nobody is
+ * merged, as the bombs reach everybody within their radius regardless of lines and contacts.
+ *
+ * @param map - The position of the root
+ * @param player - The player we search for
+ * @param isPlayingPhase - Used to distinguish between playing and bombing phase
+ */
+void SearchContext::coalesceOpponents(Map& map, uint8_t player, bool isPlayingPhase)
+{
+	Interaction interactions[MAX_PLAYER+1];
+	map.getInteractions(player, interactions);
+
+	// The opponents considered by the paranoid search, in the order in which they move
+	uint8_t considered[MAX_PLAYER];
+	int consideredCount=0;
+	int strongestInteraction=0;
+	for(uint8_t p=map.getNextPlayer(player); p!=player && consideredCount<map.getAmountOfConsideredPlayers()-1; p=map.getNextPlayer(p))
+	{
+		considered[consideredCount++]=p;
+		strongestInteraction = max(strongestInteraction, interactions[p].contacts+interactions[p].sharedLines);
+	}
 
-#ifdef BENCHMARK
-					endTimer();
-#endif
+	uint8_t order[MAX_PLAYER+1];
+	int orderCount=0;
+	uint64_t coalescedSet=0;
+	coalescedCount=0;
+	order[orderCount++]=player;
 
-					updateBestMove(cell, 0, &best);
+	cout << "Merging the opponents more than "<<COALESCING_DISTANCE<<" steps away or with less than "<<COALESCING_SHARE
+		 << "% of the strongest interaction of "<<strongestInteraction<<" (contacts + shared lines), "
+		 << "their ply is skipped with less than "<<coalescingDepth<<" plies left" << endl;
+	for(int o=0; o<consideredCount; ++o)
+	{
+		uint8_t p=considered[o];
+		Interaction& interaction = interactions[p];
+		int strength = interaction.contacts+interaction.sharedLines;
+		bool isWeak = isPlayingPhase && (interaction.distance>COALESCING_DISTANCE || 100*strength<COALESCING_SHARE*strongestInteraction);
 
-					nextMoves->insert(pair<int,int>(score,cell));
+		cout << "Player "<<(int)p<<": ";
+		if(interaction.distance==INT_MAX)
+		{
+			cout << "not reachable";
+		}
+		else
+		{
+			cout << interaction.distance<<" steps";
+		}
+		cout << ", "<<interaction.contacts<<" contacts, "<<interaction.sharedLines<<" shared lines, "<<(isWeak ? "merged" : "own ply") << endl;
 
-					mapCopy.copy(map);
-				}
+		if(isWeak)
+		{
+			if(coalescedCount==0)
+			{
+				order[orderCount++]=COALESCED_PLAYER;
 			}
+			coalescedPlayers[coalescedCount++]=p;
+			coalescedSet |= 1u<<p;
+		}
+		else
+		{
+			order[orderCount++]=p;
 		}
+	}
 
-		return best;
+	for(int i=0; i<orderCount; ++i)
+	{
+		coalescedOrder[order[i]]=order[(i+1)%orderCount];
 	}
-	else // bombing phase
+	rootPlayerKey ^= COALESCING_KEY*(2*coalescedSet+1);
+}
+
+/**
+ * Execute the first iteration of move sorting.
+ *
+ * @param map - The inital state of the game
+ * @param player - Identifies who can make the next move
+ * @param rootMoves - Filled with all possible moves, ordered by their value
+ * @param isPlayingPhase - Used to distinguish between playing and bombing phase
+ */
+int64_t SearchContext::moveSorting_firstIte(Map& map, uint8_t player, vector<RootMove>& rootMoves, bool isPlayingPhase)
+{
+	nodesAnalyzed++;
+
+	UndoRecord undo;
+
+	Move moveBuffer[map.getMaximumMoveCount()];
+	MoveList moves = {moveBuffer, 0};
+	map.generateMoves(player, isPlayingPhase, moves);
+
+	int64_t best = INT64_MIN;
+	rootMoves.clear();
+
+	for(int m=0; m<moves.count; ++m)
 	{
-		for(int cell=0; cell<getAmountOfCells(); ++cell)
-		{
-			if(mapCopy.isBombingPhaseMoveValid(cell,player,0)) // If move is valid
-			{
-				nodesAnalyzed++;
-#ifdef BENCHMARK
-				startTimer();
-#endif
+		Move& move = moves.moves[m];
 
-				score=mapCopy.evaluateForBombingPhase(playerID);
-				if(hasTimePassed){
-					return 0;
-				}
+		if(hasTimeRunOut()){
+			return 0;
+		}
+
+		map.makeMove(move.cell, player, move.choice, isPlayingPhase, captureBuffer.data(), undo);
+		nodesAnalyzed++;
 
 #ifdef BENCHMARK
-				endTimer();
+		startTimer();
 #endif
 
-				updateBestMove(cell, 0, &best);
+		if(isPlayingPhase)
+		{
+			score=map.evaluateForPlayingPhase(playerID);
+		}
+		else
+		{
+			score=map.evaluateForBombingPhase(playerID);
+		}
+		map.unmakeMove(undo);
+		if(hasTimeRunOut()){
+			return 0;
+		}
 
-				nextMoves->insert(pair<int,int>(score,cell));
+#ifdef BENCHMARK
+		endTimer();
+#endif
 
-				mapCopy.copy(map);
-			}
-		}
+		updateBestMove(move.cell, move.choice, &best);
 
-		return best;
+		RootMove rootMove = {move, score, 1};
+		rootMoves.push_back(rootMove);
 	}
+
+	sortRootMoves(rootMoves);
+	return best;
 }
 
 /**
@@ -587,14 +1361,11 @@ int64_t moveSorting_firstIte(Map& map, uint8_t player, multimap<int,int>* nextMo
  * @param currentDepth - The depth to which the subtree should be built
  * @param alpha - The alpha value for alpha-beta-pruning
  * @param beta - The beta value for alpha-beta-pruning
- * @param curMoves - A pointer to a list over which should be iterated for the moves in the root of the search tree
- * @param nextMoves - A pointer to a list to specify the order of moves for the next iteration
+ * @param rootMoves - The moves of the root in the order they are searched, gets the values and node counts of the iteration
  * @param isPlayingPhase - Used to distinguish between playing and bombing phase
  */
-int64_t moveSorting(Map& map, uint8_t player, int currentDepth, int64_t alpha, int64_t beta, multimap<int,int>* curMoves, multimap<int,int>* nextMoves, bool isPlayingPhase)
+int64_t SearchContext::moveSorting(Map& map, uint8_t player, int currentDepth, int64_t alpha, int64_t beta, vector<RootMove>* rootMoves, bool isPlayingPhase)
 {
-	static int numberOfRepeatings=0;
-
 	nodesAnalyzed++;
 
 	if(currentDepth==0)
@@ -620,466 +1391,296 @@ int64_t moveSorting(Map& map, uint8_t player, int currentDepth, int64_t alpha, i
 		return score;
 	}
 
-	Map mapCopy;
-	mapCopy.copy(map);
+	UndoRecord undo;
 
 	int64_t best=INT64_MIN;
 
-	uint8_t nextPlayer=getNextPlayer(player);
+	uint8_t nextPlayer=getNextSearchedPlayer(map, player, currentDepth);
+	bool isFirstChild=true;
 
 	if(currentDepth==initialDepth)
 	{
+		return searchRoot(map, player, alpha, beta, *rootMoves, isPlayingPhase);
+	}
 
-		numberOfRepeatings=0;
-		if(isPlayingPhase)
-		{
-			char state;
+	// Any node that is not the root or a leaf
 
-			for (multimap<int,int>::reverse_iterator cell = curMoves->rbegin(); cell != curMoves->rend(); ++cell)
-			{
-				state= map.getState((*cell).second);
+	uint64_t key = map.getHashKey(player, isPlayingPhase) ^ rootPlayerKey;
+	TranspositionEntry entry;
+	if(probeTranspositionTable(key, currentDepth, alpha, beta, entry))
+	{
+		return entry.score;
+	}
 
-				if(state=='b')
-				{
-					int64_t overrideScore;
+	int64_t alphaOrig=alpha, betaOrig=beta;
+	bool hasFoundMove=false;
+	Move* bestNodeMove=NULL;
 
-					if(mapCopy.isPlayingPhaseMoveValid((*cell).second,player,20)) // If move is valid
-					{
-						score = moveSorting(mapCopy, nextPlayer, currentDepth-1, alpha, beta, NULL, NULL, true);
-						overrideScore=score;
-						if(hasTimePassed){
-							return 0;
-						}
-
-						if(overrideScore>best)
-						{
-							best=overrideScore;
-						}
-
-						if(overrideScore>alpha)
-						{
-							alpha=overrideScore;
-							updateBestMove((*cell).second, 20, &best);
-
-						}
-						mapCopy.copy(map);
-					}
-
-					if(mapCopy.isPlayingPhaseMoveValid((*cell).second,player,21)) // If move is valid
-					{
-						score = moveSorting(mapCopy, nextPlayer, currentDepth-1, alpha, beta, NULL, NULL, true);
-						if(hasTimePassed){
-							return 0;
-						}
-
-						if(score>best)
-						{
-							best=score;
-						}
+	if(player!=playerID)
+	{
+		best=INT64_MAX;
+	}
 
-						if(score>alpha)
-						{
-							alpha=score;
-							updateBestMove((*cell).second, 21, &best);
-						}
+	int ply = initialDepth-currentDepth;
+	Move moveBuffer[map.getMaximumMoveCount()];
+	MoveList moves = {moveBuffer, 0};
+	if(player==COALESCED_PLAYER)
+	{
+		moves = generateMergedMoves(map, ply, coalescedPlayers, coalescedCount, isPlayingPhase);
+	}
+	else
+	{
+		map.generateMoves(player, isPlayingPhase, moves);
+	}
 
-						if(score>overrideScore)
-						{
-							nextMoves->insert(pair<int,int>(score,(*cell).second));
-						}
-						else
-						{
-							nextMoves->insert(pair<int,int>(overrideScore,(*cell).second));
-						}
+	// The moves are searched by their rating, the best one left is only selected when it is needed
+	uint32_t ratings[moves.count];
+	rateMoves(map, ply, moves, entry, ratings, isPlayingPhase);
 
-						mapCopy.copy(map);
-					}
-				}
-				else if(state=='c')
-				{
-					int64_t max=INT64_MIN;
+	for(int m=0; m<moves.count; ++m)
+	{
+		selectMove(moves, ratings, m);
+		map.makeMove(moves.moves[m].cell, moves.moves[m].player, moves.moves[m].choice, isPlayingPhase, captureBuffer.data(), undo);
+		hasFoundMove=true;
+		numberOfRepeatings=0;
 
-					for(uint8_t p=1; p<=getAmountOfPlayers(); ++p)
-					{
-						if(mapCopy.isPlayingPhaseMoveValid((*cell).second, player, p)) // If move is valid
-						{
-							score=moveSorting(mapCopy, nextPlayer ,currentDepth-1, alpha, beta, NULL, NULL, true); // Go deeper into the tree
-							if(hasTimePassed){
-								return 0;
-							}
-
-							if(score>max)
-							{
-								max=score;
-							}
-
-							if(score>best)
-							{
-								best=score;
-							}
-
-							if(score>alpha)
-							{
-								alpha=score;
-								updateBestMove((*cell).second, p, &best);
-							}
-							mapCopy.copy(map);
-						}
-					}
+		score = searchChild(map, nextPlayer, currentDepth-1, alpha, beta, player==playerID, isFirstChild, isPlayingPhase);
+		map.unmakeMove(undo);
+		if(isSearchStopped()){
+			return 0;
+		}
 
-					nextMoves->insert(pair<int,int>(max, (*cell).second));
-				}
-				else
+		if(player==playerID) // maximizer
+		{
+			if(score>best){
+				best=score;
+				bestNodeMove=&moves.moves[m];
+				if(score>alpha)
 				{
-					if(mapCopy.isPlayingPhaseMoveValid((*cell).second,player,0)) // If move is valid
-					{
-						int score = moveSorting(mapCopy, nextPlayer, currentDepth-1, alpha, beta, NULL, NULL, true);
-						if(hasTimePassed){
-							return 0;
-						}
-
-						if(score>best)
-						{
-							best=score;
-						}
-
-						if(score>alpha)
-						{
-							alpha=score;
-							updateBestMove((*cell).second, 0, &best);
-						}
-
-						nextMoves->insert(pair<int,int>(score,(*cell).second));
-
-						mapCopy.copy(map);
-					}
+					alpha=score;
 				}
 			}
 		}
-		else // bombing phase
+		else // minimizer
 		{
-			for (multimap<int,int>::reverse_iterator cell = curMoves->rbegin(); cell != curMoves->rend(); ++cell)
+			if(score<best)
 			{
-				if(mapCopy.isBombingPhaseMoveValid((*cell).second, player, 0)) // If move is valid
+				best=score;
+				bestNodeMove=&moves.moves[m];
+				if(score<beta)
 				{
-					score = moveSorting(mapCopy, nextPlayer, currentDepth-1, alpha, beta, NULL, NULL, false);
-					if(hasTimePassed){
-						return 0;
-					}
-
-					if(score>best)
-					{
-						best=score;
-					}
-
-					if(score>alpha)
-					{
-						alpha=score;
-						updateBestMove((*cell).second, 0, &best);
-					}
-
-					nextMoves->insert(pair<int,int>(score,(*cell).second));
-
-					mapCopy.copy(map);
+					beta=score;
 				}
 			}
 		}
 
-		return best; // Return alpha to indicate the score of the best move found
+		// Check if node can be pruned away
+		if(alpha>=beta)
+		{
+			recordCutoff(map, ply, currentDepth, moves.moves[m], m==0, isPlayingPhase);
+			storeTranspositionEntry(key, currentDepth, alphaOrig, betaOrig, best, bestNodeMove);
+			return best;
+		}
 	}
 
-	// Any node that is not the root or a leaf
-
-	bool hasFoundMove=false;
-
-	if(player!=playerID)
+	// If no move has been found execute it for the next player in the list, except if no player can make a move
+	if(!hasFoundMove && numberOfRepeatings<map.getAmountOfConsideredPlayers())
 	{
-		best=INT_MAX;
+		numberOfRepeatings++;
+		return moveSorting(map, nextPlayer, currentDepth, alpha, beta, NULL, isPlayingPhase);
 	}
-
-	if(isPlayingPhase)
+	else if(!hasFoundMove) // If no player can make a move in the current phase
 	{
-		char state;
-
-		for(int cell=0; cell<getAmountOfCells(); ++cell)
+		if(isPlayingPhase) // Change to bombing phase if we are in the playing phase
 		{
-			state= map.getState(cell);
-			if(state=='b')
+			if(!getConsiderOverrideStones())
 			{
-				if(mapCopy.isPlayingPhaseMoveValid(cell,player,21)) // If move is valid
-				{
-					hasFoundMove=true;
-					numberOfRepeatings=0;
-
-					score = moveSorting(mapCopy, nextPlayer, currentDepth-1, alpha, beta, NULL, NULL, true);
-					if(hasTimePassed){
-						return 0;
-					}
-
-					if(player==playerID) // maximizer
-					{
-						if(score>best){
-							best=score;
-							if(score>alpha)
-							{
-								alpha=score;
-							}
-						}
-					}
-					else // minimizer
-					{
-						if(score<best)
-						{
-							best=score;
-							if(score<beta)
-							{
-								beta=score;
-							}
-						}
-					}
-					// Check if node can be pruned away
-					if(alpha>=beta)
-					{
-						return best;
-					}
+				setConsiderOverrideStones(true);
+				numberOfRepeatings=0;
+				return moveSorting(map, nextPlayer, currentDepth, alpha, beta, NULL, true);
+			}
+			return moveSorting(map, nextPlayer, currentDepth, alpha, beta, NULL, false);
+		}
+		else // Evaluate for end of game otherwise
+		{
+			return map.evaluateForEndOfGame(playerID);
+		}
+	}
 
-					mapCopy.copy(map);
-				}
+	storeTranspositionEntry(key, currentDepth, alphaOrig, betaOrig, best, bestNodeMove);
+	return best;
+}
 
-				if(mapCopy.isPlayingPhaseMoveValid(cell,player,21)) // If move is valid
-				{
-					score = moveSorting(mapCopy, nextPlayer, currentDepth-1, alpha, beta, NULL, NULL, true);
-					if(hasTimePassed){
-						return 0;
-					}
+/**
+ * Searches the moves of the root of the move sorting or of the best-reply search in the order of the list. The value
+ * and the nodes of every move are written to its entry of the list and the best move is remembered.
+ *
+ * @param map - The inital state of the game
+ * @param player - The player we search for
+ * @param alpha - The alpha value for alpha-beta-pruning
+ * @param beta - The beta value for alpha-beta-pruning
+ * @param rootMoves - The moves of the root in the order they are searched
+ * @param isPlayingPhase - Used to distinguish between playing and bombing phase
+ * @return The value of the best move
+ */
+int64_t SearchContext::searchRoot(Map& map, uint8_t player, int64_t alpha, int64_t beta, vector<RootMove>& rootMoves, bool isPlayingPhase)
+{
+	UndoRecord undo;
 
-					if(player==playerID) // maximizer
-					{
-						if(score>best){
-							best=score;
-							if(score>alpha)
-							{
-								alpha=score;
-							}
-						}
-					}
-					else // minimizer
-					{
-						if(score<best)
-						{
-							best=score;
-							if(score<beta)
-							{
-								beta=score;
-							}
-						}
-					}
-					// Check if node can be pruned away
-					if(alpha>=beta)
-					{
-						return best;
-					}
+	int64_t best=INT64_MIN;
 
-					mapCopy.copy(map);
-				}
-			}
-			else if(state=='c')
-			{
-				for(uint8_t p=1; p<=getAmountOfPlayers();  ++p)
-				{
-					if(mapCopy.isPlayingPhaseMoveValid(cell, player, p)) // If move is valid
-					{
-						hasFoundMove=true;
-						numberOfRepeatings=0;
+	uint8_t nextPlayer=getNextSearchedPlayer(map, player, initialDepth);
+	bool isFirstChild=true;
 
-						score = moveSorting(mapCopy, nextPlayer, currentDepth-1, alpha, beta, NULL, NULL, true);
-						if(hasTimePassed){
-							return 0;
-						}
+	numberOfRepeatings=0;
 
-						if(player==playerID) // maximizer
-						{
-							if(score>best){
-								best=score;
-								if(score>alpha)
-								{
-									alpha=score;
-								}
-							}
-						}
-						else // minimizer
-						{
-							if(score<best)
-							{
-								best=score;
-								if(score<beta)
-								{
-									beta=score;
-								}
-							}
-						}
-						// Check if node can be pruned away
-						if(alpha>=beta)
-						{
-							return best;
-						}
+	for(size_t r=0; r<rootMoves.size(); ++r)
+	{
+		RootMove& rootMove = rootMoves[r];
+		uint64_t subtreeStart = nodesAnalyzed;
 
-						mapCopy.copy(map);
-					}
-				}
+		if(map.makeMove(rootMove.move.cell, player, rootMove.move.choice, isPlayingPhase, captureBuffer.data(), undo)) // If move is valid
+		{
+			if(isBestReply)
+			{
+				score = bestReply(map, initialDepth-1, alpha, beta, true, false, isPlayingPhase);
 			}
 			else
 			{
-				if(mapCopy.isPlayingPhaseMoveValid(cell,player,0)) // If move is valid
-				{
-					hasFoundMove=true;
-					numberOfRepeatings=0;
-
-					score = moveSorting(mapCopy, nextPlayer, currentDepth-1, alpha, beta, NULL, NULL, true);
-					if(hasTimePassed){
-						return 0;
-					}
+				score = searchChild(map, nextPlayer, initialDepth-1, alpha, beta, true, isFirstChild, isPlayingPhase);
+			}
+			map.unmakeMove(undo);
+			if(isSearchStopped()){
+				return 0;
+			}
 
-					if(player==playerID) // maximizer
-					{
-						if(score>best){
-							best=score;
-							if(score>alpha)
-							{
-								alpha=score;
-							}
-						}
-					}
-					else // minimizer
-					{
-						if(score<best)
-						{
-							best=score;
-							if(score<beta)
-							{
-								beta=score;
-							}
-						}
-					}
+			rootMove.score=score;
+			rootMove.nodes=nodesAnalyzed-subtreeStart;
 
-					// Check if node can be pruned away
-					if(alpha>=beta)
-					{
-						return best;
-					}
+			if(score>best)
+			{
+				best=score;
+			}
 
-					mapCopy.copy(map);
-				}
+			if(score>alpha)
+			{
+				alpha=score;
+				updateBestMove(rootMove.move.cell, rootMove.move.choice, &best);
 			}
 		}
 	}
-	else // bombing phase
-	{
-		for (int cell=0; cell<getAmountOfCells(); ++cell)
-		{
-			if(mapCopy.isBombingPhaseMoveValid(cell, player, 0)) // If move is valid
-			{
-				hasFoundMove=true;
-				numberOfRepeatings=0;
-				score = moveSorting(mapCopy, nextPlayer, currentDepth-1, alpha, beta, NULL, NULL, false);
-				if(hasTimePassed){
-					return 0;
-				}
 
-				if(player==playerID) // maximizer
-				{
-					if(score>best){
-						best=score;
-						if(score>alpha)
-						{
-							alpha=score;
-						}
-					}
-				}
-				else // minimizer
-				{
-					if(score<best)
-					{
-						best=score;
-						if(score<beta)
-						{
-							beta=score;
-						}
-					}
-				}
-				// Check if node can be pruned away
-				if(alpha>=beta)
-				{
-					return best;
-				}
+	return best;
+}
 
-				mapCopy.copy(map);
-			}
-		}
+/**
+ * Searches a child of a node of the move sorting. If the search is scouting, only the first child is searched
+ * with the full window. The younger brothers are searched with a null window, which only proves that they are
+ * not better than the best move so far, and again with the full window if the proof fails.
+ *
+ * @param map - The state of the game after the move to the child
+ * @param player - The player who moves in the child
+ * @param currentDepth - The depth to which the subtree of the child should be built
+ * @param alpha - The alpha value of the node
+ * @param beta - The beta value of the node
+ * @param isMaximizer - Set if the player of the node is the one we search for
+ * @param isFirstChild - Set if no other child of the node has been searched yet, is unset by this function
+ * @param isPlayingPhase - Used to distinguish between playing and bombing phase
+ * @return The value of the child
+ */
+inline int64_t SearchContext::searchChild(Map& map, uint8_t player, int currentDepth, int64_t alpha, int64_t beta, bool isMaximizer, bool& isFirstChild, bool isPlayingPhase)
+{
+	// A leaf is rated exactly by any window
+	if(!isScouting || isFirstChild || currentDepth==0)
+	{
+		isFirstChild=false;
+		return moveSorting(map, player, currentDepth, alpha, beta, NULL, isPlayingPhase);
 	}
 
-	// If no move has been found execute it for the next player in the list, except if no player can make a move
-	if(!hasFoundMove && numberOfRepeatings<getAmountOfConsideredPlayers())
+	int64_t value;
+	if(isMaximizer)
 	{
-		numberOfRepeatings++;
-		return moveSorting(mapCopy, nextPlayer, currentDepth, alpha, beta, NULL, NULL, isPlayingPhase);
+		value = moveSorting(map, player, currentDepth, alpha, alpha+1, NULL, isPlayingPhase);
 	}
-	else if(!hasFoundMove) // If no player can make a move in the current phase
+	else
 	{
-		if(isPlayingPhase) // Change to bombing phase if we are in the playing phase
+		value = moveSorting(map, player, currentDepth, beta-1, beta, NULL, isPlayingPhase);
+	}
+
+	// The null window failed, so the child is better than the best move so far and the value found is a bound of it
+	if(alpha<value && value<beta && !isSearchStopped())
+	{
+		if(isMaximizer)
 		{
-			if(!getConsiderOverrideStones())
-			{
-				setConsiderOverrideStones(true);
-				numberOfRepeatings=0;
-				return moveSorting(mapCopy, nextPlayer, currentDepth, alpha, beta, NULL, NULL, true);
-			}
-			return moveSorting(mapCopy, nextPlayer, currentDepth, alpha, beta, NULL, NULL, false);
+			value = moveSorting(map, player, currentDepth, value, beta, NULL, isPlayingPhase);
 		}
-		else // Evaluate for end of game otherwise
+		else
 		{
-			return map.evaluateForEndOfGame(playerID);
+			value = moveSorting(map, player, currentDepth, alpha, value, NULL, isPlayingPhase);
 		}
 	}
-
-	return best;
+	return value;
 }
 
 /**
- * Execute minimax with alphabeta pruning to a specified depth. If the timer for the move runs out, 0 is returned immediately.
- * For alphabeta pruning every node has the information which is the minimal(in case of minimizer nodes) or the maximal(in case of maximizer nodes) value
- * of its parent node. While building its subtree, it constantly checks whether its value is higher than the reference value(if parent=minimizer) or lower
- * otherwise. If this is the case, the node returns immediatly and the subtree is pruned away.
- *
- * @param map - The initial game state
- * @param turn - The player who has to make a move
- * @param depth - Specifies to what depth the game tree should be built
- * @param isPlayingPhase - Specifies in which phase of the game currently is active
- * @param alpha - The currently highest value of a parent maximizer
- * @param beta - The currently lowest value of a parant minimizer
+ * Generates the moves of several players, which move in the same ply. The moves do not fit on the stack,
+ * so every ply has a buffer for them, which is used until the moves of the ply have been searched.
  *
- * @return The minimal value of all child nodes in case of minimizer, the maximum value otherwise
+ * @param map - The state of the game
+ * @param ply - The distance of the node from the root
+ * @param players - The players whose moves are generated
+ * @param playerCount - The amount of players
+ * @param isPlayingPhase - Used to distinguish between playing and bombing phase
+ * @return The moves of all players, one player after another
  */
-int64_t alphabeta(Map& map, uint8_t turn, int depth, bool isPlayingPhase, int64_t alpha, int64_t beta)
+MoveList SearchContext::generateMergedMoves(Map& map, int ply, const uint8_t* players, int playerCount, bool isPlayingPhase)
 {
-	static int numberOfRepeatings = 0;
+	size_t bufferSize = max(1, playerCount)*map.getMaximumMoveCount();
+	if((int)replyBuffers.size()<=ply)
+	{
+		replyBuffers.resize(ply+1);
+	}
+	if(replyBuffers[ply].size()<bufferSize)
+	{
+		replyBuffers[ply].resize(bufferSize);
+	}
 
-	if(hasTimePassed){
-		return 0;
+	MoveList moves = {replyBuffers[ply].data(), 0};
+	for(int p=0; p<playerCount; ++p)
+	{
+		MoveList playerMoves = {moves.moves+moves.count, 0};
+		map.generateMoves(players[p], isPlayingPhase, playerMoves);
+		moves.count += playerMoves.count;
 	}
+	return moves;
+}
 
+/**
+ * The best-reply search of BEST_REPLY, which is an alphabeta search for the player we search for. Our moves alternate
+ * with a layer of replies, which holds the moves of all opponents, as if the opponent with the strongest reply would
+ * move next. The other opponents do not move before our next move, so a round of the game takes two plies instead of
+ * one for every player and our own moves are searched much deeper than by the paranoid search, on the cost of
+ * positions that cannot occur in the game. The root is searched by searchRoot().
+ *
+ * @param map - The state of the game
+ * @param currentDepth - The depth to which the subtree should be built
+ * @param alpha - The alpha value for alpha-beta-pruning
+ * @param beta - The beta value for alpha-beta-pruning
+ * @param isReplying - Set for the layer of the replies of the opponents, unset for our moves
+ * @param hasPassed - Set if the layer before could not move, so that nobody can move if this one cannot either
+ * @param isPlayingPhase - Used to distinguish between playing and bombing phase
+ * @return The value of the node
+ */
+int64_t SearchContext::bestReply(Map& map, int currentDepth, int64_t alpha, int64_t beta, bool isReplying, bool hasPassed, bool isPlayingPhase)
+{
 	nodesAnalyzed++;
 
-	int64_t score;
-
-	if(depth==0)	// If a leaf is reached, analyze the state for every player and return the value
+	if(currentDepth==0)
 	{
-
 #ifdef BENCHMARK
 		startTimer();
 #endif
 
-
 		if(isPlayingPhase)
 		{
 			score = map.evaluateForPlayingPhase(playerID);
@@ -1096,625 +1697,278 @@ int64_t alphabeta(Map& map, uint8_t turn, int depth, bool isPlayingPhase, int64_
 		return score;
 	}
 
-	Map mapCopy;
-
-	bool foundMove = false;
+	uint64_t key = map.getHashKey(playerID, isPlayingPhase) ^ rootPlayerKey ^ (isReplying ? BEST_REPLIES_KEY : BEST_REPLY_KEY);
+	TranspositionEntry entry;
+	if(probeTranspositionTable(key, currentDepth, alpha, beta, entry))
+	{
+		return entry.score;
+	}
 
-	uint8_t state;
+	int64_t alphaOrig=alpha, betaOrig=beta;
+	int64_t best = isReplying ? INT64_MAX : INT64_MIN;
+	Move* bestNodeMove=NULL;
+	UndoRecord undo;
 
-	int64_t best=INT64_MIN;
+	int ply = initialDepth-currentDepth;
+	uint8_t self = playerID;
+	MoveList moves = isReplying ? generateMergedMoves(map, ply, opponents, opponentCount, isPlayingPhase)
+								: generateMergedMoves(map, ply, &self, 1, isPlayingPhase);
 
-	if(turn!=playerID)
-	{
-		best=INT64_MAX;
-	}
+	// The moves are searched by their rating, the best one left is only selected when it is needed
+	uint32_t ratings[moves.count];
+	rateMoves(map, ply, moves, entry, ratings, isPlayingPhase);
 
-	for(int i=0; i<getAmountOfCells(); ++i)
+	for(int m=0; m<moves.count; ++m)
 	{
-		mapCopy.copy(map);
+		selectMove(moves, ratings, m);
+		Move& move = moves.moves[m];
 
-		if(hasTimePassed)
-		{
+		map.makeMove(move.cell, move.player, move.choice, isPlayingPhase, captureBuffer.data(), undo);
+		score = bestReply(map, currentDepth-1, alpha, beta, !isReplying, false, isPlayingPhase);
+		map.unmakeMove(undo);
+		if(isSearchStopped()){
 			return 0;
 		}
 
-		if(isPlayingPhase)
+		if(!isReplying) // maximizer
 		{
-			state = map.getState(i);
-
-			switch(state)
+			if(score>best)
 			{
-				case 'b':	if(mapCopy.isPlayingPhaseMoveValid(i,turn,20)) // If move is valid
-							{
-								if(!foundMove)	// if no move has been found so far, use the first one
-								{
-									foundMove=true;
-									numberOfRepeatings=0;	// reset counter
-								}
-
-								// Get the next player, who has not been disqualified
-								nextPlayer=(turn%numberOfPlayers)+1;
-								while(isDisqualified(nextPlayer))
-								{
-									nextPlayer=(nextPlayer%numberOfPlayers)+1;
-								}
-
-								int score;
-								score=alphabeta(mapCopy, nextPlayer, depth-1, true, alpha, beta); // Go deeper into the tree
-
-								if(turn==playerID) // maximizer
-								{
-									if(score>best){
-										best=score;
-										if(score>alpha)
-										{
-											alpha=score;
-											if(depth==initialDepth)
-											{
-												currentCell=i;
-												currentChoice=20;
-											}
-										}
-									}
-								}
-								else // minimizer
-								{
-									if(score<best)
-									{
-										best=score;
-										if(score<beta)
-										{
-											beta=score;
-										}
-									}
-								}
-
-								// Prune away the rest of the tree
-								if(alpha>=beta)
-								{
-									return score;
-								}
-							}
-
-							if(mapCopy.isPlayingPhaseMoveValid(i,turn,21)) // If move is valid
-							{
-								if(!foundMove)	// if no move has been found so far, use the first one
-								{
-									foundMove=true;
-									numberOfRepeatings=0;	// reset counter
-								}
-
-								// Get the next player, who has not been disqualified
-								nextPlayer=(turn%numberOfPlayers)+1;
-								while(isDisqualified(nextPlayer))
-								{
-									nextPlayer=(nextPlayer%numberOfPlayers)+1;
-								}
-
-								int score;
-								score=alphabeta(mapCopy, nextPlayer, depth-1, true, alpha, beta); // Go deeper into the tree
-
-								if(turn==playerID) // maximizer
-								{
-									if(score>best){
-										best=score;
-										if(score>alpha)
-										{
-											alpha=score;
-											if(depth==initialDepth)
-											{
-												currentCell=i;
-												currentChoice=21;
-											}
-										}
-									}
-								}
-								else // minimizer
-								{
-									if(score<best)
-									{
-										best=score;
-										if(score<beta)
-										{
-											beta=score;
-										}
-									}
-								}
-
-								// Prune away the rest of the tree
-								if(alpha>=beta)
-								{
-									return score;
-								}
-							}
-							break;
-
-				case 'c':	for(uint8_t p=1; p<=getAmountOfPlayers(); ++p)
-							{
-								if(!foundMove)	// if no move has been found so far, use the first one
-								{
-									foundMove=true;
-									numberOfRepeatings=0;	// reset counter
-								}
-
-								if(mapCopy.isPlayingPhaseMoveValid(i,turn,p)) // If move is valid
-								{
-									// Get the next player, who has not been disqualified
-									nextPlayer=(turn%numberOfPlayers)+1;
-									while(isDisqualified(nextPlayer))
-									{
-										nextPlayer=(nextPlayer%numberOfPlayers)+1;
-									}
-
-									int score;
-									score=alphabeta(mapCopy, nextPlayer, depth-1, true, alpha, beta); // Go deeper into the tree
-
-									if(turn==playerID) // maximizer
-									{
-										if(score>best){
-											best=score;
-											if(score>alpha)
-											{
-												alpha=score;
-												if(depth==initialDepth)
-												{
-													currentCell=i;
-													currentChoice=p;
-												}
-											}
-										}
-									}
-									else // minimizer
-									{
-										if(score<best)
-										{
-											best=score;
-											if(score<beta)
-											{
-												beta=score;
-											}
-										}
-									}
-
-									// Prune away the rest of the tree
-									if(alpha>=beta)
-									{
-										return score;
-									}
-								}
-							}
-							break;
-
-				default:	if(mapCopy.isPlayingPhaseMoveValid(i,turn,0)) // If move is valid
-							{
-								if(!foundMove)	// if no move has been found so far, use the first one
-								{
-									foundMove=true;
-									numberOfRepeatings=0;	// reset counter
-								}
-
-								// Get the next player, who has not been disqualified
-								nextPlayer=(turn%numberOfPlayers)+1;
-								while(isDisqualified(nextPlayer))
-								{
-									nextPlayer=(nextPlayer%numberOfPlayers)+1;
-								}
-
-								int score;
-								score=alphabeta(mapCopy, nextPlayer, depth-1, true, alpha, beta); // Go deeper into the tree
-
-								if(turn==playerID) // maximizer
-								{
-									if(score>best){
-										best=score;
-										if(score>alpha)
-										{
-											alpha=score;
-											if(depth==initialDepth)
-											{
-												currentCell=i;
-												currentChoice=0;
-											}
-										}
-									}
-								}
-								else // minimizer
-								{
-									if(score<best)
-									{
-										best=score;
-										if(score<beta)
-										{
-											beta=score;
-										}
-									}
-								}
-
-								// Prune away the rest of the tree
-								if(alpha>=beta)
-								{
-									return score;
-								}
-							}
-							break;
+				best=score;
+				bestNodeMove=&move;
+				if(score>alpha)
+				{
+					alpha=score;
+				}
 			}
 		}
-		else //-----BOMBING PHASE------
+		else // minimizer
 		{
-			if(mapCopy.isBombingPhaseMoveValid(i,turn,0)) // If move is valid
+			if(score<best)
 			{
-				if(!foundMove)	// if no move has been found so far, use the first one
-				{
-					foundMove=true;
-					numberOfRepeatings=0;	// reset counter
-				}
-
-				// Get the next player, who has not been disqualified
-				nextPlayer=(turn%numberOfPlayers)+1;
-				while(isDisqualified(nextPlayer))
-				{
-					nextPlayer=(nextPlayer%numberOfPlayers)+1;
-				}
-
-				int score;
-				score=alphabeta(mapCopy, nextPlayer, depth-1, false, alpha, beta); // Go deeper into the tree
-
-				if(turn==playerID) // maximizer
-				{
-					if(score>best){
-						best=score;
-						if(score>alpha)
-						{
-							alpha=score;
-							if(depth==initialDepth)
-							{
-								currentCell=i;
-								currentChoice=0;
-							}
-						}
-					}
-				}
-				else // minimizer
-				{
-					if(score<best)
-					{
-						best=score;
-						if(score<beta)
-						{
-							beta=score;
-						}
-					}
-				}
-
-				// Prune away the rest of the tree
-				if(alpha>=beta)
+				best=score;
+				bestNodeMove=&move;
+				if(score<beta)
 				{
-					return score;
+					beta=score;
 				}
 			}
 		}
-	}
-
-	// If no move has been found execute it for the next player in the list, except if no player can make a move
-	if(!foundMove && numberOfRepeatings<numberOfPlayers)
-	{
-		numberOfRepeatings++;
 
-		nextPlayer=(turn%numberOfPlayers)+1;
-		while(isDisqualified(nextPlayer))
+		// Check if node can be pruned away
+		if(alpha>=beta)
 		{
-			nextPlayer=(nextPlayer%numberOfPlayers)+1;
+			recordCutoff(map, ply, currentDepth, move, m==0, isPlayingPhase);
+			storeTranspositionEntry(key, currentDepth, alphaOrig, betaOrig, best, bestNodeMove);
+			return best;
 		}
-
-		return alphabeta(mapCopy, nextPlayer, depth-1, true, alpha, beta);
 	}
-	else if(!foundMove)			// If no player can make a move switch to bombing phase if
+
+	if(moves.count==0)
 	{
-		if(isPlayingPhase)		// We are in the playing phase. Else just evaluate the board.
+		// Let the other side move, unless it could not move either
+		if(!hasPassed)
 		{
-			nextPlayer=(turn%numberOfPlayers)+1;
-			while(isDisqualified(nextPlayer))
+			return bestReply(map, currentDepth, alpha, beta, !isReplying, true, isPlayingPhase);
+		}
+		else if(isPlayingPhase) // Consider override stones and then change to the bombing phase, like the move sorting
+		{
+			if(!getConsiderOverrideStones())
 			{
-				nextPlayer=(nextPlayer%numberOfPlayers)+1;
+				setConsiderOverrideStones(true);
+				return bestReply(map, currentDepth, alpha, beta, isReplying, false, true);
 			}
-
-			return alphabeta(mapCopy, nextPlayer, depth, false, alpha, beta);
-
+			return bestReply(map, currentDepth, alpha, beta, isReplying, false, false);
 		}
-		else
+		else // Evaluate for end of game otherwise
 		{
 			return map.evaluateForEndOfGame(playerID);
 		}
 	}
 
-	return best;	// Should only be reached if no player can make a move
+	storeTranspositionEntry(key, currentDepth, alphaOrig, betaOrig, best, bestNodeMove);
+	return best;
 }
 
 /**
- * Executing minimax with paranoid strategy.
- * The board will be analyzed for the given player at the leafs of the game tree.
- * At each node the value shall be maximized for the given player turn, minimized for others.
- * A player's turn is represented by the branches leaving that specific node.
+ * The search of a helper thread of LAZY_SMP. It runs the iterative deepening of the move sorting on its
+ * own copy of the map until the main thread is done. Its results only reach the main thread through the
+ * transposition table, where they give the main thread cutoffs and better move orderings.
+ * So that the helpers do not search the same nodes at the same time as the main thread, every helper
+ * starts with a shuffled order of the root moves and every second helper searches one ply deeper.
  *
- * @param map			 	- The current board state
- * @param turn				- The player who has to make a move
- * @param depth				- How deep(amount of successive moves) the algorithm should look from a specific node
- * @param isPlayingPhase	- Set if we are in the playing phase or bombing phase
- * @return		The evaluation value of the best move for that node
+ * @param map - The copy of the initial state of the game, which belongs to this helper
+ * @param helperIndex - The number of the helper, starting with 0
+ * @param searchDepth - The depth up to which the helper searches
+ * @param player - The player who can make a move
+ * @param isPlayingPhase - Used to distinguish between playing and bombing phase
+ * @param toConsiderOverrideStones - Whether the main thread considers override stones
+ * @param rootMoves - The moves of the root found by the first iteration of the main thread
  */
-int64_t minimax(Map& map, uint8_t turn, int depth, bool isPlayingPhase)
+void SearchContext::searchAsHelper(Map* map, int helperIndex, int searchDepth, uint8_t player, bool isPlayingPhase, bool toConsiderOverrideStones, vector<RootMove> rootMoves)
 {
-	static int numberOfRepeatings = 0;
+	setConsiderOverrideStones(toConsiderOverrideStones);
+
+	mt19937 random(helperIndex);
+	shuffle(rootMoves.begin(), rootMoves.end(), random);
+
+	for(int depth=2+helperIndex%2; depth<=searchDepth && !isSearchStopped(); ++depth)
+	{
+		initialDepth=depth;
+		moveSorting(*map, player, depth, INT64_MIN, INT64_MAX, &rootMoves, isPlayingPhase);
+		if(isSearchStopped())
+		{
+			break;
+		}
+
+		sortRootMoves(rootMoves);
+	}
+
+	mainSearch->helperNodesAnalyzed += nodesAnalyzed;
+}
 
-	if(hasTimePassed){
+/**
+ * Execute minimax with alphabeta pruning to a specified depth. If the timer for the move runs out, 0 is returned immediately.
+ * For alphabeta pruning every node has the information which is the minimal(in case of minimizer nodes) or the maximal(in case of maximizer nodes) value
+ * of its parent node. While building its subtree, it constantly checks whether its value is higher than the reference value(if parent=minimizer) or lower
+ * otherwise. If this is the case, the node returns immediatly and the subtree is pruned away.
+ *
+ * @param map - The initial game state
+ * @param turn - The player who has to make a move
+ * @param depth - Specifies to what depth the game tree should be built
+ * @param isPlayingPhase - Specifies in which phase of the game currently is active
+ * @param alpha - The currently highest value of a parent maximizer
+ * @param beta - The currently lowest value of a parant minimizer
+ *
+ * @return The minimal value of all child nodes in case of minimizer, the maximum value otherwise
+ */
+int64_t SearchContext::alphabeta(Map& map, uint8_t turn, int depth, bool isPlayingPhase, int64_t alpha, int64_t beta)
+{
+	if(hasTimeRunOut()){
 		return 0;
 	}
 
-#ifdef BENCHMARK
 	nodesAnalyzed++;
-#endif
 
-	if((depth<=0))	// If a leaf is reached, analyze the state for every player and return the value
+	int64_t score;
+
+	if(depth==0)	// If a leaf is reached, analyze the state for every player and return the value
 	{
 
 #ifdef BENCHMARK
 		startTimer();
 #endif
 
-		int64_t evaValue;
+
 		if(isPlayingPhase)
 		{
-			evaValue=map.evaluateForPlayingPhase(playerID);
+			score = map.evaluateForPlayingPhase(playerID);
 		}
 		else
 		{
-			evaValue = map.evaluateForBombingPhase(playerID);
+			score = map.evaluateForBombingPhase(playerID);
 		}
 
 #ifdef BENCHMARK
 		endTimer();
 #endif
 
-		return evaValue;
+		return score;
 	}
 
-	Map mapCopy;
-
-	bool foundMove=false;
-	int64_t best = INT_MIN;
-
-	uint8_t state;
-
-	for(int i=0; i<getAmountOfCells(); i++)
+	// The root is never cut off, as its best move has to be set
+	uint64_t key = map.getHashKey(turn, isPlayingPhase) ^ rootPlayerKey;
+	TranspositionEntry entry;
+	if(probeTranspositionTable(key, depth, alpha, beta, entry) && depth!=initialDepth)
 	{
-		if(isPlayingPhase)
-		{
-			state = map.getState(i);
-
-			if(state=='b')	// If that specific cell is a bonus cell, execute both moves:
-			{				// Picking a bomb or picking an override stone
-
-				mapCopy.copy(map);
-
-				if(mapCopy.isPlayingPhaseMoveValid(i,turn,20)) // If move is valid
-				{
-					if(!foundMove)
-					{
-						foundMove=true;
-					}
+		return entry.score;
+	}
 
-					numberOfRepeatings=0;	//reset counter
+	UndoRecord undo;
 
-					int32_t score;
+	int64_t alphaOrig=alpha, betaOrig=beta;
+	bool foundMove = false;
+	Move* bestNodeMove=NULL;
 
-					nextPlayer=(turn%numberOfPlayers)+1;
-					while(isDisqualified(nextPlayer))
-					{
-						nextPlayer=(nextPlayer%numberOfPlayers)+1;
-					}
+	int64_t best=INT64_MIN;
 
-					score=minimax(mapCopy,nextPlayer ,depth-1,true); // Go deeper into the tree
-					if(hasTimePassed)	// stop the search if no time is left.
-					{
-						return 0;	// Close every recursion stack and use the previous found move
-					}
+	if(turn!=playerID)
+	{
+		best=INT64_MAX;
+	}
 
-					if(turn==playerID)	// Maximizer node
-					{
-						if(depth==initialDepth)
-						{
-							updateBestMove(i, 20, &best);
-						}
-						else if (score>best)
-						{
-							best=score;
-						}
-					}
-					else if(best<score)			// Minimizer node
-					{
-						best=score;
-					}
-				}
+	Move moveBuffer[map.getMaximumMoveCount()];
+	MoveList moves = {moveBuffer, 0};
+	map.generateMoves(turn, isPlayingPhase, moves);
+	sortTranspositionMove(moves, entry);
 
-				mapCopy.copy(map);
+	for(int m=0; m<moves.count; ++m)
+	{
+		Move& move = moves.moves[m];
 
-				if(mapCopy.isPlayingPhaseMoveValid(i,turn,21)) // If move is valid
-				{
-					if(!foundMove)
-					{
-						foundMove=true;
-					}
+		if(hasTimeRunOut())
+		{
+			return 0;
+		}
 
-					numberOfRepeatings=0;	// Reset counter
+		map.makeMove(move.cell, turn, move.choice, isPlayingPhase, captureBuffer.data(), undo);
 
-					int64_t score;
+		if(!foundMove)	// if no move has been found so far, use the first one
+		{
+			foundMove=true;
+			numberOfRepeatings=0;	// reset counter
+		}
 
-					nextPlayer=(turn%numberOfPlayers)+1;
-					while(isDisqualified(nextPlayer))
-					{
-						nextPlayer=(nextPlayer%numberOfPlayers)+1;
-					}
+		// Get the next player, who has not been disqualified
+		nextPlayer=(turn%numberOfPlayers)+1;
+		while(map.isDisqualified(nextPlayer))
+		{
+			nextPlayer=(nextPlayer%numberOfPlayers)+1;
+		}
 
-					score=minimax(mapCopy,nextPlayer ,depth-1,true); // Go deeper into the tree
-					if(hasTimePassed)	// stop the search if no time is left.
-					{
-						return 0;	// Close every recursion stack and use the previous found move
-					}
+		int64_t score;
+		score=alphabeta(map, nextPlayer, depth-1, isPlayingPhase, alpha, beta); // Go deeper into the tree
+		map.unmakeMove(undo);
 
-					if(turn==playerID)	// Maximizer node
-					{
-						if(depth==initialDepth)
-						{
-							updateBestMove(i, 21, &best);
-						}
-						else if (score>best)
-						{
-							best=score;
-						}
-					}
-					else if(best<score)			// Minimizer node
-					{
-						best=score;
-					}
-				}
-			}
-			else if(state=='c')					// If the cell is a choose stone,
-			{									// Swap with every possible player.
-				for(uint8_t p=1; p<=getAmountOfPlayers();p++)
+		if(turn==playerID) // maximizer
+		{
+			if(score>best){
+				best=score;
+				bestNodeMove=&move;
+				if(score>alpha)
 				{
-					mapCopy.copy(map);
-
-					if(mapCopy.isPlayingPhaseMoveValid(i,turn,p)) // If move is valid
+					alpha=score;
+					if(depth==initialDepth)
 					{
-						if(!foundMove)
-						{
-							foundMove=true;
-						}
-
-						numberOfRepeatings=0;	// Reset counter
-
-						int32_t score;
-
-						nextPlayer=(turn%numberOfPlayers)+1;
-						while(isDisqualified(nextPlayer))
-						{
-							nextPlayer=(nextPlayer%numberOfPlayers)+1;
-						}
-
-						score=minimax(mapCopy,nextPlayer ,depth-1,true); // Go deeper into the tree
-
-						if(hasTimePassed)	// Stop the search if no time is left
-						{
-							return 0;	// Close every recursion stack and use the previous found move
-						}
-
-						if(turn==playerID)	// Maximizer node
-						{
-							if(depth==initialDepth)
-							{
-								updateBestMove(i, 21, &best);
-							}
-							else if (score>best)
-							{
-								best=score;
-							}
-						}
-						else if(best<score)			// Minimizer node
-						{
-							best=score;
-						}
+						currentCell=move.cell;
+						currentChoice=move.choice;
 					}
 				}
 			}
-			else	// In every other case just try playing a stone
+		}
+		else // minimizer
+		{
+			if(score<best)
 			{
-				mapCopy.copy(map);
-
-				if(mapCopy.isPlayingPhaseMoveValid(i,turn,0)) // If move is valid
+				best=score;
+				bestNodeMove=&move;
+				if(score<beta)
 				{
-					if(!foundMove)
-					{
-						foundMove=true;
-					}
-
-					numberOfRepeatings=0;	// Reset counter
-
-					int32_t score;
-
-					nextPlayer=(turn%numberOfPlayers)+1;
-					while(isDisqualified(nextPlayer))
-					{
-						nextPlayer=(nextPlayer%numberOfPlayers)+1;
-					}
-
-					score=minimax(mapCopy,nextPlayer ,depth-1,true); // Go deeper into the tree
-					if(hasTimePassed)	// Stop the search if no time is left.
-					{
-						return 0;	// Close every recursion stack and use the previous found move
-					}
-
-					if(turn==playerID)	// Maximizer node
-					{
-						if(depth==initialDepth)
-						{
-							updateBestMove(i, 21, &best);
-						}
-						else if (score>best)
-						{
-							best=score;
-						}
-					}
-					else if(best<score)			// Minimizer node
-					{
-						best=score;
-					}
+					beta=score;
 				}
 			}
 		}
-		else //-----BOMBING PHASE------
-		{
-			mapCopy.copy(map);
 
-			if(mapCopy.isBombingPhaseMoveValid(i,turn,0)) // If move is valid
+		// Prune away the rest of the tree
+		if(alpha>=beta)
+		{
+			cutoffCount++;
+			if(m==0)
 			{
-				if(!foundMove)
-				{
-					foundMove=true;
-				}
-
-				numberOfRepeatings=0;	// Reset counter
-
-				int score=0;
-
-				nextPlayer=(turn%numberOfPlayers)+1;
-				while(isDisqualified(nextPlayer))
-				{
-					nextPlayer=(nextPlayer%numberOfPlayers)+1;
-				}
-
-				score=minimax(mapCopy,nextPlayer ,depth-1,false); // Go deeper into the tree
-
-				if(hasTimePassed)	// Stop the search if no time is left.
-				{
-					return 0;	// Close every recursion stack and use the previous found move
-				}
-
-				if(turn==playerID)	// Maximizer node
-				{
-					if(depth==initialDepth)
-					{
-						updateBestMove(i, 21, &best);
-					}
-					else if (score>best)
-					{
-						best=score;
-					}
-				}
-				else if(best<score)			// Minimizer node
-				{
-					best=score;
-				}
+				firstMoveCutoffCount++;
 			}
+			storeTranspositionEntry(key, depth, alphaOrig, betaOrig, score, bestNodeMove);
+			return score;
 		}
 	}
 
@@ -1724,25 +1978,24 @@ int64_t minimax(Map& map, uint8_t turn, int depth, bool isPlayingPhase)
 		numberOfRepeatings++;
 
 		nextPlayer=(turn%numberOfPlayers)+1;
-		while(isDisqualified(nextPlayer))
+		while(map.isDisqualified(nextPlayer))
 		{
 			nextPlayer=(nextPlayer%numberOfPlayers)+1;
 		}
 
-		return minimax(mapCopy, nextPlayer, depth-1, true); // Go deeper into the tree
-
+		return alphabeta(map, nextPlayer, depth-1, isPlayingPhase, alpha, beta);
 	}
-	else if(!foundMove)// If no player can make a move switch to bombing phase if
+	else if(!foundMove)			// If no player can make a move switch to bombing phase if
 	{
-		if(isPlayingPhase) // We are in the playing phase. Else just evaluate the board.
+		if(isPlayingPhase)		// We are in the playing phase. Else just evaluate the board.
 		{
 			nextPlayer=(turn%numberOfPlayers)+1;
-			while(isDisqualified(nextPlayer))
+			while(map.isDisqualified(nextPlayer))
 			{
 				nextPlayer=(nextPlayer%numberOfPlayers)+1;
 			}
 
-			return minimax(mapCopy, nextPlayer ,depth, false);
+			return alphabeta(map, nextPlayer, depth, false, alpha, beta);
 
 		}
 		else
@@ -1751,48 +2004,1034 @@ int64_t minimax(Map& map, uint8_t turn, int depth, bool isPlayingPhase)
 		}
 	}
 
-	return best;
+	storeTranspositionEntry(key, depth, alphaOrig, betaOrig, best, bestNodeMove);
+	return best;	// Should only be reached if no player can make a move
 }
 
 /**
- * Start the timer during benchmarking.
+ * Returns the player who moves after the given one, skipping the disqualified players.
+ *
+ * @param map  - The map whose game decides which players are disqualified
+ * @param turn - The player who made the last move
+ * @return The next player who has not been disqualified
  */
-void startTimer()
+inline uint8_t SearchContext::getNextActivePlayer(Map& map, uint8_t turn)
 {
-	clock_gettime(CLOCK_REALTIME, &spec);
-	startTime = spec.tv_sec*1000000000 + (spec.tv_nsec);
+	uint8_t next=(turn%numberOfPlayers)+1;
+	while(map.isDisqualified(next))
+	{
+		next=(next%numberOfPlayers)+1;
+	}
+	return next;
 }
 
 /**
- * Stops the timer during benchmarking.
+ * Returns the player who moves after the given one in the move sorting. OPPONENT_COALESCING follows its own turn
+ * order, in which the merged opponents move in one ply, see coalesceOpponents(). That ply is skipped once less
+ * than coalescingDepth plies are left, as the distant opponents can hardly change the outcome of a short line.
+ *
+ * @param map - The map whose considered players give the turn order
+ * @param player - The player who moves at the node
+ * @param currentDepth - The depth left at the node
+ * @return The player who moves in the children of the node
  */
-void endTimer()
+inline uint8_t SearchContext::getNextSearchedPlayer(Map& map, uint8_t player, int currentDepth)
 {
-	clock_gettime(CLOCK_REALTIME, &spec);
-	endTime = spec.tv_sec*1000000000 + (spec.tv_nsec);
-	timeSpendEvaluating += endTime-startTime;				// only for evaluation
+	if(!isCoalescing)
+	{
+		return map.getNextPlayer(player);
+	}
+
+	uint8_t next=coalescedOrder[player];
+	if(next==COALESCED_PLAYER && currentDepth-1<coalescingDepth)
+	{
+		next=coalescedOrder[next];
+	}
+	return next;
 }
 
 /**
- * Returns the number of analysed nodes if the BENCHMARK flag has been set during compilation
+ * Returns whether the search of a split point or one of its ancestors has been cut off,
+ * in which case the results of the moves below it are not needed anymore.
  *
- * @return The number of created nodes(incl. leafs) during the move search
+ * @param split - The split point, NULL if the node has no split ancestor
  */
-uint64_t getNumberOfAnalyzedNodes()
+inline bool isSplitCutOff(SplitPoint* split)
 {
-	uint64_t temp=nodesAnalyzed;
-	nodesAnalyzed=0;
-	return temp;
+	for(; split!=NULL; split=split->parent)
+	{
+		if(split->isCutOff.load(memory_order_relaxed))
+		{
+			return true;
+		}
+	}
+	return false;
 }
 
 /**
- * Returns the time spend evaluating leafs if the BENCHMARK flag has been set during compilation
+ * Adds the value of a move to the window and the best move of a node of PARALLEL_ALPHABETA.
+ * Equal values at the root are decided by the order of the moves, so that the chosen move
+ * does not depend on the order in which the threads finish their moves.
  *
- * @return The time in milliseconds spend evaluating game states.
+ * @param isMaximizer - Whether the node belongs to the player for whom the search is done
+ * @param isRoot - Whether the node is the root of the search
+ * @param index - The index of the move in the move list of the node
+ * @param value - The value returned by the move
+ * @param best - The best value of the node
+ * @param bestIndex - The index of the best move, -1 if there is none yet
+ * @param alpha - The alpha value of the node
+ * @param beta - The beta value of the node
+ *
+ * @return True if the move causes a cutoff, false otherwise
  */
-long getTimeSpendEvaluating()
+inline bool updateWindow(bool isMaximizer, bool isRoot, int index, int64_t value, int64_t& best, int& bestIndex, int64_t& alpha, int64_t& beta)
 {
-	long temp=timeSpendEvaluating/1000000;
-	timeSpendEvaluating=0;
+	if(isMaximizer)
+	{
+		if(value>best || (isRoot && value==best && (bestIndex<0 || index<bestIndex)))
+		{
+			best=value;
+			bestIndex=index;
+		}
+		if(value>alpha)
+		{
+			alpha=value;
+		}
+	}
+	else
+	{
+		if(value<best)
+		{
+			best=value;
+			bestIndex=index;
+		}
+		if(value<beta)
+		{
+			beta=value;
+		}
+	}
+
+	return alpha>=beta;
+}
+
+/**
+ * Execute alphabeta with the Young Brothers Wait Concept on the threads of the search pool. The eldest child of a node
+ * is searched first, the younger brothers are then handed to the pool, as only then the window is known which they can
+ * be searched with. The tasks are searched by the thread that created them, unless another thread steals them first.
+ * A cutoff of a node stops the searches of all its moves.
+ * The transposition table is only used to sort the moves, as a stored score depends on the path by which the position
+ * was reached and on the order in which the threads store their results. Like this the value and the best move do not
+ * depend on the amount of threads.
+ *
+ * @param map - The current game state
+ * @param turn - The player who has to make a move
+ * @param depth - Specifies to what depth the game tree should be built
+ * @param isPlayingPhase - Specifies in which phase of the game currently is active
+ * @param alpha - The currently highest value of a parent maximizer
+ * @param beta - The currently lowest value of a parant minimizer
+ * @param passes - The amount of players who could not move right before this node
+ * @param parentSplit - The split point of the closest ancestor that has been split, NULL if there is none
+ *
+ * @return The minimal value of all child nodes in case of minimizer, the maximum value otherwise
+ */
+int64_t SearchContext::parallelAlphabeta(Map& map, uint8_t turn, int depth, bool isPlayingPhase, int64_t alpha, int64_t beta, int passes, SplitPoint* parentSplit)
+{
+	if(hasTimeRunOut() || isSplitCutOff(parentSplit))
+	{
+		return 0;
+	}
+
+	nodesAnalyzed++;
+
+	if(depth==0)	// If a leaf is reached, analyze the state for every player and return the value
+	{
+		int64_t score;
+
+#ifdef BENCHMARK
+		startTimer();
+#endif
+
+		if(isPlayingPhase)
+		{
+			score = map.evaluateForPlayingPhase(playerID);
+		}
+		else
+		{
+			score = map.evaluateForBombingPhase(playerID);
+		}
+
+#ifdef BENCHMARK
+		endTimer();
+#endif
+
+		return score;
+	}
+
+	// The threads of the pool never search the root, so only the main thread can get here with the initial depth
+	bool isRoot = parentSplit==NULL && depth==initialDepth;
+
+	// The root searches the best move of the last iteration first, which is not kept in the table for sure
+	uint64_t key = map.getHashKey(turn, isPlayingPhase) ^ rootPlayerKey;
+	TranspositionEntry entry;
+	if(isRoot)
+	{
+		entry.cell = initialDepth>1 ? currentCell : NO_CELL;
+		entry.choice = currentChoice;
+	}
+	else
+	{
+		probeTranspositionTable(key, depth, alpha, beta, entry);
+	}
+
+	Move moveBuffer[map.getMaximumMoveCount()];
+	MoveList moves = {moveBuffer, 0};
+	map.generateMoves(turn, isPlayingPhase, moves);
+	sortTranspositionMove(moves, entry);
+
+	uint8_t next = getNextActivePlayer(map, turn);
+
+	// If no move has been found execute it for the next player in the list, except if no player can make a move
+	if(moves.count==0)
+	{
+		if(passes<numberOfPlayers)
+		{
+			return parallelAlphabeta(map, next, depth-1, isPlayingPhase, alpha, beta, passes+1, parentSplit);
+		}
+		else if(isPlayingPhase)	// If no player can make a move switch to bombing phase
+		{
+			return parallelAlphabeta(map, next, depth, false, alpha, beta, passes, parentSplit);
+		}
+		else
+		{
+			return map.evaluateForEndOfGame(playerID);
+		}
+	}
+
+	UndoRecord undo;
+
+	bool isMaximizer = turn==playerID;
+	int64_t alphaOrig=alpha, betaOrig=beta;
+	int64_t best = isMaximizer ? INT64_MIN : INT64_MAX;
+	int bestIndex = -1;
+
+	// Search the eldest brother, or all moves if the node is too small to be split
+	int m=0;
+	for(; m<moves.count && (m==0 || depth<MIN_SPLIT_DEPTH || mainSearch->searchPool->getThreadCount()==1); ++m)
+	{
+		Move& move = moves.moves[m];
+
+		map.makeMove(move.cell, turn, move.choice, isPlayingPhase, captureBuffer.data(), undo);
+		int64_t score = parallelAlphabeta(map, next, depth-1, isPlayingPhase, alpha, beta, 0, parentSplit);
+		map.unmakeMove(undo);
+
+		if(hasTimeRunOut() || isSplitCutOff(parentSplit))
+		{
+			return 0;
+		}
+
+		// Prune away the rest of the tree
+		if(updateWindow(isMaximizer, isRoot, m, score, best, bestIndex, alpha, beta))
+		{
+			storeTranspositionEntry(key, depth, alphaOrig, betaOrig, best, bestIndex>=0 ? &moves.moves[bestIndex] : NULL);
+			return best;
+		}
+	}
+
+	// Hand the younger brothers to the pool and search them until all of them are done
+	if(m<moves.count)
+	{
+		if(splitMaps.size()==splitMapCount)
+		{
+			splitMaps.push_back(unique_ptr<Map>(new Map()));
+		}
+		Map* splitMap = splitMaps[splitMapCount++].get();
+		splitMap->copy(map);
+
+		SplitPoint split;
+		split.parent = parentSplit;
+		split.mainSearch = mainSearch;
+		split.map = splitMap;
+		split.moves = moves.moves;
+		split.turn = turn;
+		split.depth = depth;
+		split.isPlayingPhase = isPlayingPhase;
+		split.isRoot = isRoot;
+		split.alpha = alpha;
+		split.beta = beta;
+		split.best = best;
+		split.bestIndex = bestIndex;
+		split.pendingMoves = moves.count-m;
+		split.isCutOff = false;
+
+		// The own deque is used as a stack, so the moves are pushed in reverse to search them in order
+		for(int i=moves.count-1; i>=m; --i)
+		{
+			Task task = {searchStolenMove, &split, i};
+			mainSearch->searchPool->push(task);
+		}
+
+		while(split.pendingMoves>0)
+		{
+			Task task;
+			if(mainSearch->searchPool->pop(task, &split))
+			{
+				searchSplitMove(map, &split, task.index);
+			}
+			else	// The remaining moves have been stolen
+			{
+				this_thread::yield();
+			}
+		}
+
+		splitMapCount--;
+
+		if(hasTimeRunOut() || isSplitCutOff(parentSplit))
+		{
+			return 0;
+		}
+
+		best = split.best;
+		bestIndex = split.bestIndex;
+	}
+
+	if(isRoot && bestIndex>=0)
+	{
+		currentCell=moves.moves[bestIndex].cell;
+		currentChoice=moves.moves[bestIndex].choice;
+	}
+
+	storeTranspositionEntry(key, depth, alphaOrig, betaOrig, best, bestIndex>=0 ? &moves.moves[bestIndex] : NULL);
+	return best;
+}
+
+/**
+ * Searches one move of a split point on the given map and adds its value to the split point.
+ * The move is skipped if the split point has been cut off in the meantime.
+ *
+ * @param map - The position of the split point, it is the same after the move has been searched
+ * @param split - The split point the move belongs to
+ * @param index - The index of the move in the move list of the split point
+ */
+void SearchContext::searchSplitMove(Map& map, SplitPoint* split, int index)
+{
+	if(!hasTimeRunOut() && !isSplitCutOff(split))
+	{
+		int64_t alpha, beta;
+		{
+			lock_guard<mutex> guard(split->lock);
+			alpha = split->alpha;
+			beta = split->beta;
+		}
+
+		UndoRecord undo;
+		Move& move = split->moves[index];
+		uint8_t next = getNextActivePlayer(map, split->turn);
+
+		map.makeMove(move.cell, split->turn, move.choice, split->isPlayingPhase, captureBuffer.data(), undo);
+		int64_t score = parallelAlphabeta(map, next, split->depth-1, split->isPlayingPhase, alpha, beta, 0, split);
+
+		// A root move that fails low with the best value might be as good as the best move. If it comes first
+		// in the move list, it is searched again with a lower alpha to decide the tie like the sequential search.
+		if(split->isRoot && alpha>INT64_MIN && score<=alpha)
+		{
+			bool isTie;
+			{
+				lock_guard<mutex> guard(split->lock);
+				isTie = score==split->best && index<split->bestIndex;
+			}
+			if(isTie)
+			{
+				score = parallelAlphabeta(map, next, split->depth-1, split->isPlayingPhase, alpha-1, beta, 0, split);
+			}
+		}
+
+		map.unmakeMove(undo);
+
+		if(!hasTimeRunOut() && !isSplitCutOff(split))
+		{
+			lock_guard<mutex> guard(split->lock);
+			if(updateWindow(split->turn==playerID, split->isRoot, index, score, split->best, split->bestIndex, split->alpha, split->beta))
+			{
+				split->isCutOff = true;
+			}
+		}
+	}
+
+	split->pendingMoves--;
+}
+
+/**
+ * Searches a move that has been stolen from another thread. It is made on a copy of the position of its split point,
+ * as the thread which created the split point keeps changing its own map.
+ *
+ * @param data - The split point the move belongs to
+ * @param index - The index of the move in the move list of the split point
+ */
+void SearchContext::searchStolenMove(void* data, int index)
+{
+	SplitPoint* split = (SplitPoint*)data;
+	SearchContext* search = split->mainSearch->workerSearches[WorkStealingPool::getWorkerIndex()].get();
+
+	if(!search->stolenMoveMap)
+	{
+		search->stolenMoveMap.reset(new Map());
+	}
+	setConsiderOverrideStones(split->mainSearch->isConsideringOverrideStones);
+
+	if(!isSplitCutOff(split))
+	{
+		search->stolenMoveMap->copy(*split->map);
+	}
+	search->searchSplitMove(*search->stolenMoveMap, split, index);
+
+	split->mainSearch->helperNodesAnalyzed += search->nodesAnalyzed;
+	search->nodesAnalyzed = 0;
+}
+
+/**
+ * Executing minimax with paranoid strategy.
+ * The board will be analyzed for the given player at the leafs of the game tree.
+ * At each node the value shall be maximized for the given player turn, minimized for others.
+ * A player's turn is represented by the branches leaving that specific node.
+ *
+ * @param map			 	- The current board state
+ * @param turn				- The player who has to make a move
+ * @param depth				- How deep(amount of successive moves) the algorithm should look from a specific node
+ * @param isPlayingPhase	- Set if we are in the playing phase or bombing phase
+ * @return		The evaluation value of the best move for that node
+ */
+int64_t SearchContext::minimax(Map& map, uint8_t turn, int depth, bool isPlayingPhase)
+{
+	if(hasTimeRunOut()){
+		return 0;
+	}
+
+	nodesAnalyzed++;
+
+	if((depth<=0))	// If a leaf is reached, analyze the state for every player and return the value
+	{
+
+#ifdef BENCHMARK
+		startTimer();
+#endif
+
+		int64_t evaValue;
+		if(isPlayingPhase)
+		{
+			evaValue=map.evaluateForPlayingPhase(playerID);
+		}
+		else
+		{
+			evaValue = map.evaluateForBombingPhase(playerID);
+		}
+
+#ifdef BENCHMARK
+		endTimer();
+#endif
+
+		return evaValue;
+	}
+
+	UndoRecord undo;
+
+	bool foundMove=false;
+	int64_t best = INT_MIN;
+
+	Move moveBuffer[map.getMaximumMoveCount()];
+	MoveList moves = {moveBuffer, 0};
+	map.generateMoves(turn, isPlayingPhase, moves);
+
+	for(int m=0; m<moves.count; m++)
+	{
+		Move& move = moves.moves[m];
+
+		map.makeMove(move.cell, turn, move.choice, isPlayingPhase, captureBuffer.data(), undo);
+
+		if(!foundMove)
+		{
+			foundMove=true;
+		}
+
+		numberOfRepeatings=0;	// Reset counter
+
+		int64_t score;
+
+		nextPlayer=(turn%numberOfPlayers)+1;
+		while(map.isDisqualified(nextPlayer))
+		{
+			nextPlayer=(nextPlayer%numberOfPlayers)+1;
+		}
+
+		score=minimax(map,nextPlayer ,depth-1,isPlayingPhase); // Go deeper into the tree
+		map.unmakeMove(undo);
+		if(hasTimeRunOut())	// Stop the search if no time is left.
+		{
+			return 0;	// Close every recursion stack and use the previous found move
+		}
+
+		if(turn==playerID)	// Maximizer node
+		{
+			if(depth==initialDepth)
+			{
+				updateBestMove(move.cell, move.choice, &best);
+			}
+			else if (score>best)
+			{
+				best=score;
+			}
+		}
+		else if(best<score)			// Minimizer node
+		{
+			best=score;
+		}
+	}
+
+	// If no move has been found execute it for the next player in the list, except if no player can make a move
+	if(!foundMove && numberOfRepeatings<numberOfPlayers)
+	{
+		numberOfRepeatings++;
+
+		nextPlayer=(turn%numberOfPlayers)+1;
+		while(map.isDisqualified(nextPlayer))
+		{
+			nextPlayer=(nextPlayer%numberOfPlayers)+1;
+		}
+
+		return minimax(map, nextPlayer, depth-1, isPlayingPhase); // Go deeper into the tree
+
+	}
+	else if(!foundMove)// If no player can make a move switch to bombing phase if
+	{
+		if(isPlayingPhase) // We are in the playing phase. Else just evaluate the board.
+		{
+			nextPlayer=(turn%numberOfPlayers)+1;
+			while(map.isDisqualified(nextPlayer))
+			{
+				nextPlayer=(nextPlayer%numberOfPlayers)+1;
+			}
+
+			return minimax(map, nextPlayer ,depth, false);
+
+		}
+		else
+		{
+			return map.evaluateForEndOfGame(playerID);
+		}
+	}
+
+	return best;
+}
+
+/**
+ * Looks up a position in the transposition table and checks whether its stored result can be used
+ * instead of searching the position. This is the case if it was searched at least as deep and
+ * the score is exact or its bound lies outside of the window.
+ *
+ * @param key - The hash key of the position
+ * @param depth - The depth to which the position should be searched
+ * @param alpha - The alpha value of the node
+ * @param beta - The beta value of the node
+ * @param entry - Is filled with the stored result, its cell is NO_CELL if the position was not found
+ *
+ * @return True if the score of the entry can be returned for the node, false otherwise
+ */
+bool SearchContext::probeTranspositionTable(uint64_t key, int depth, int64_t alpha, int64_t beta, TranspositionEntry& entry)
+{
+	if(!table->probe(key, entry))
+	{
+		entry.cell=NO_CELL;
+		return false;
+	}
+
+	if(entry.depth<depth)
+	{
+		return false;
+	}
+
+	return entry.bound==EXACT_BOUND
+		|| (entry.bound==LOWER_BOUND && entry.score>=beta)
+		|| (entry.bound==UPPER_BOUND && entry.score<=alpha);
+}
+
+/**
+ * Stores the result of a searched node in the transposition table, unless the search was
+ * stopped. The bound is given by the window the node was searched with.
+ *
+ * @param key - The hash key of the position
+ * @param depth - The depth to which the position was searched
+ * @param alpha - The alpha value the node was called with
+ * @param beta - The beta value the node was called with
+ * @param value - The value returned by the node
+ * @param move - The best move of the node, NULL if there is none
+ */
+void SearchContext::storeTranspositionEntry(uint64_t key, int depth, int64_t alpha, int64_t beta, int64_t value, Move* move)
+{
+	if(isSearchStopped())
+	{
+		return;
+	}
+
+	TranspositionEntry entry;
+	entry.score=value;
+	entry.depth=depth;
+	entry.cell=NO_CELL;
+	entry.choice=0;
+
+	if(value<=alpha)
+	{
+		entry.bound=UPPER_BOUND;
+	}
+	else if(value>=beta)
+	{
+		entry.bound=LOWER_BOUND;
+	}
+	else
+	{
+		entry.bound=EXACT_BOUND;
+	}
+
+	if(move!=NULL)
+	{
+		entry.cell=move->cell;
+		entry.choice=move->choice;
+	}
+
+	table->store(key, entry);
+}
+
+/**
+ * Moves the best move stored for a position to the front of the move list, so that it is searched first.
+ * The order of the other moves is kept.
+ *
+ * @param moves - The moves of the position
+ * @param entry - The entry found by probeTranspositionTable()
+ */
+void sortTranspositionMove(MoveList& moves, TranspositionEntry& entry)
+{
+	if(entry.cell==NO_CELL)
+	{
+		return;
+	}
+
+	for(int m=1; m<moves.count; ++m)
+	{
+		if(moves.moves[m].cell==entry.cell && moves.moves[m].choice==entry.choice)
+		{
+			rotate(moves.moves, moves.moves+m, moves.moves+m+1);
+			return;
+		}
+	}
+}
+
+/**
+ * Prepares the move ordering of the move sorting for a new search. The killer moves are dropped, as their plies
+ * start at another root, while the history is halved, so that it still orders the moves until the search has found
+ * its own cutoffs. The history is cleared if the map has another size than the one of the last search.
+ *
+ * @param map - The initial state of the game
+ */
+void SearchContext::startMoveOrdering(Map& map)
+{
+	Move noMove = {0, 0, 0, 0, 0};
+	for(int ply=0; ply<MAX_KILLER_PLY; ++ply)
+	{
+		killerMoves[ply][0]=noMove;
+		killerMoves[ply][1]=noMove;
+	}
+
+	size_t historySize = (size_t)(MAX_PLAYER+1)*map.getAmountOfCells()*HISTORY_SLOTS;
+	if(history.size()!=historySize)
+	{
+		history.assign(historySize, 0);
+	}
+	else
+	{
+		for(size_t i=0; i<history.size(); ++i)
+		{
+			history[i] >>= 1;
+		}
+	}
+
+	cutoffCount=0;
+	firstMoveCutoffCount=0;
+}
+
+/**
+ * Returns the index of a move in the history. Every player has HISTORY_SLOTS slots on every cell, so that moves on
+ * the same cell which do something else are told apart: 0 for a normal move, 1 for the override of a stone, 2 to 9
+ * for the players that can be chosen on a choice cell, 10 for the bomb and 11 for the override stone of a bonus cell
+ * and 12 for a bomb thrown in the bombing phase.
+ *
+ * @param map - The state of the game before the move is made
+ * @param player - The player who makes the move
+ * @param move - The move
+ * @param isPlayingPhase - Used to distinguish between playing and bombing phase
+ * @return The index of the move in history
+ */
+inline int SearchContext::getHistoryIndex(Map& map, uint8_t player, Move& move, bool isPlayingPhase)
+{
+	int slot;
+	if(!isPlayingPhase)
+	{
+		slot=12;
+	}
+	else if(move.choice==20 || move.choice==21)
+	{
+		slot=move.choice-10;
+	}
+	else if(move.choice>0)
+	{
+		slot=move.choice+1;
+	}
+	else
+	{
+		uint8_t state = map.getState(move.cell);
+		slot = ((state>0 && state<=MAX_PLAYER) || state=='x') ? 1 : 0;
+	}
+
+	return (player*map.getAmountOfCells()+move.cell)*HISTORY_SLOTS+slot;
+}
+
+/**
+ * Rates the moves of a node of the move sorting or the best-reply search for their order. The move of the transposition table is searched
+ * first, then the killer moves of the ply and then all other moves by their history.
+ *
+ * @param map - The state of the game at the node
+ * @param ply - The distance of the node from the root
+ * @param moves - The moves of the node
+ * @param entry - The entry of the node in the transposition table, its cell is NO_CELL if there is none
+ * @param ratings - Filled with the rating of every move, a move with a higher rating is searched earlier
+ * @param isPlayingPhase - Used to distinguish between playing and bombing phase
+ */
+inline void SearchContext::rateMoves(Map& map, int ply, MoveList& moves, TranspositionEntry& entry, uint32_t* ratings, bool isPlayingPhase)
+{
+	Move* killers = ply<MAX_KILLER_PLY ? killerMoves[ply] : NULL;
+
+	for(int m=0; m<moves.count; ++m)
+	{
+		Move& move = moves.moves[m];
+		if(move.cell==entry.cell && move.choice==entry.choice)
+		{
+			ratings[m]=TRANSPOSITION_MOVE_RATING;
+		}
+		else if(killers!=NULL && move.cell==killers[0].cell && move.choice==killers[0].choice)
+		{
+			ratings[m]=KILLER_MOVE_RATING;
+		}
+		else if(killers!=NULL && move.cell==killers[1].cell && move.choice==killers[1].choice)
+		{
+			ratings[m]=KILLER_MOVE_RATING-1;
+		}
+		else
+		{
+			ratings[m]=history[getHistoryIndex(map, move.player, move, isPlayingPhase)];
+		}
+	}
+}
+
+/**
+ * Moves the move with the highest rating of the moves that have not been searched yet to the given position.
+ * Selecting the moves one after another is cheaper than sorting them, as most nodes are cut off after a few moves.
+ *
+ * @param moves - The moves of a node
+ * @param ratings - The ratings of the moves, which are moved along with them
+ * @param m - The position of the next move to be searched, the moves before it have been searched
+ */
+static inline void selectMove(MoveList& moves, uint32_t* ratings, int m)
+{
+	int best=m;
+	for(int i=m+1; i<moves.count; ++i)
+	{
+		if(ratings[i]>ratings[best])
+		{
+			best=i;
+		}
+	}
+
+	if(best!=m)
+	{
+		swap(moves.moves[m], moves.moves[best]);
+		swap(ratings[m], ratings[best]);
+	}
+}
+
+/**
+ * Remembers a move that cut off a node of the move sorting or the best-reply search, as a killer move of its ply
+ * and in the history of the player who made it.
+ *
+ * @param map - The state of the game at the node, the move is not made
+ * @param ply - The distance of the node from the root
+ * @param depth - The depth to which the node was searched, deeper cutoffs save more nodes and count more
+ * @param move - The move that caused the cutoff
+ * @param isFirstMove - Set if the move was the first one searched at the node
+ * @param isPlayingPhase - Used to distinguish between playing and bombing phase
+ */
+void SearchContext::recordCutoff(Map& map, int ply, int depth, Move& move, bool isFirstMove, bool isPlayingPhase)
+{
+	cutoffCount++;
+	if(isFirstMove)
+	{
+		firstMoveCutoffCount++;
+	}
+
+	if(ply<MAX_KILLER_PLY && (move.cell!=killerMoves[ply][0].cell || move.choice!=killerMoves[ply][0].choice))
+	{
+		killerMoves[ply][1]=killerMoves[ply][0];
+		killerMoves[ply][0]=move;
+	}
+
+	uint32_t& rating = history[getHistoryIndex(map, move.player, move, isPlayingPhase)];
+	rating += depth*depth;
+	if(rating>HISTORY_LIMIT)
+	{
+		for(size_t i=0; i<history.size(); ++i)
+		{
+			history[i] >>= 1;
+		}
+	}
+}
+
+/**
+ * Start the timer during benchmarking.
+ */
+void SearchContext::startTimer()
+{
+	clock_gettime(CLOCK_REALTIME, &spec);
+	startTime = spec.tv_sec*1000000000 + (spec.tv_nsec);
+}
+
+/**
+ * Stops the timer during benchmarking.
+ */
+void SearchContext::endTimer()
+{
+	clock_gettime(CLOCK_REALTIME, &spec);
+	endTime = spec.tv_sec*1000000000 + (spec.tv_nsec);
+	timeSpendEvaluating += endTime-startTime;				// only for evaluation
+}
+
+/**
+ * Returns the number of analysed nodes if the BENCHMARK flag has been set during compilation
+ *
+ * @return The number of created nodes(incl. leafs) during the move search, including those of helper threads
+ */
+uint64_t SearchContext::getNumberOfAnalyzedNodes()
+{
+	uint64_t temp=nodesAnalyzed+helperNodesAnalyzed;
+	nodesAnalyzed=0;
+	helperNodesAnalyzed=0;
+	return temp;
+}
+
+/**
+ * Returns the time spend evaluating leafs if the BENCHMARK flag has been set during compilation
+ *
+ * @return The time in milliseconds spend evaluating game states.
+ */
+long SearchContext::getTimeSpendEvaluating()
+{
+	long temp=timeSpendEvaluating/1000000;
+	timeSpendEvaluating=0;
 	return temp;
 }
+
+/**
+ * Returns the amount of positions looked up in the transposition table during the last search.
+ *
+ * @return The number of probes of the transposition table
+ */
+uint64_t SearchContext::getTranspositionTableProbes()
+{
+	return result.tableProbes;
+}
+
+/**
+ * Returns the amount of positions found in the transposition table during the last search.
+ *
+ * @return The number of hits in the transposition table
+ */
+uint64_t SearchContext::getTranspositionTableHits()
+{
+	return result.tableHits;
+}
+
+/**
+ * Returns the amount of entries of the last search that got replaced by another position.
+ *
+ * @return The number of collisions in the transposition table
+ */
+uint64_t SearchContext::getTranspositionTableCollisions()
+{
+	return result.tableCollisions;
+}
+
+/**
+ * Returns how well the aspiration windows fitted during the last search.
+ *
+ * @return The window statistics of the last search, empty if it did not use ASPIRATIONAL_WINDOW
+ */
+WindowStatistics SearchContext::getWindowStatistics()
+{
+	return result.window;
+}
+
+/**
+ * Returns the amount of nodes of the last search that were cut off by one of their moves.
+ *
+ * @return The number of cutoffs of the alphabeta and the move sorting
+ */
+uint64_t SearchContext::getCutoffs()
+{
+	return result.cutoffs;
+}
+
+/**
+ * Returns the amount of cutoffs of the last search that were caused by the first move searched at the node,
+ * which shows how well the moves are ordered.
+ *
+ * @return The number of cutoffs by the first move
+ */
+uint64_t SearchContext::getFirstMoveCutoffs()
+{
+	return result.firstMoveCutoffs;
+}
+
+/**
+ * Searches the next move with the search context of the whole process.
+ * See SearchContext::search() for the parameters.
+ *
+ * @return A pointer to the move identified as the best move.
+ */
+Move* getNextMove(Map& map, int searchDepth, int searchTime, uint8_t player, int algorithm, bool isPlayingPhase)
+{
+	return &defaultSearch.search(map, searchDepth, searchTime, player, algorithm, isPlayingPhase).move;
+}
+
+/**
+ * Starts searching the next move with the search context of the whole process on a thread of its own.
+ * See SearchContext::searchAsync() for the parameters.
+ *
+ * @return The future of the result of the search
+ */
+future<SearchResult&> searchNextMoveAsync(Map& map, int searchDepth, int searchTime, uint8_t player, int algorithm, bool isPlayingPhase)
+{
+	return defaultSearch.searchAsync(map, searchDepth, searchTime, player, algorithm, isPlayingPhase);
+}
+
+/**
+ * Starts pondering with the search context of the whole process on a thread of its own.
+ * See SearchContext::ponder() for the parameters.
+ *
+ * @return The future that is ready once the pondering has been stopped by stopSearching()
+ */
+future<void> ponderAsync(Map& map, uint8_t lastPlayer, uint8_t player, int algorithm, bool isPlayingPhase)
+{
+	return defaultSearch.ponderAsync(map, lastPlayer, player, algorithm, isPlayingPhase);
+}
+
+/**
+ * Starts the opening analysis with the search context of the whole process on a thread of its own.
+ * See SearchContext::analyseOpenings() for the parameters.
+ *
+ * @return The future that is ready once the analysis has been stopped by stopSearching()
+ */
+future<void> analyseOpeningsAsync(Map& map, int algorithm, bool isPlayingPhase)
+{
+	return defaultSearch.analyseOpeningsAsync(map, algorithm, isPlayingPhase);
+}
+
+/**
+ * Asks the running search or pondering of the search context of the whole process to return as soon as possible.
+ */
+void stopSearching()
+{
+	defaultSearch.stop();
+}
+
+/**
+ * Displays the amount of failed and successful time predictions of the search context of the whole process.
+ */
+void close()
+{
+	defaultSearch.close();
+}
+
+/**
+ * Sets the size of the transposition table of the search context of the whole process.
+ *
+ * @param megabytes - The size of the table in MB
+ */
+void setTranspositionTableSize(int megabytes)
+{
+	defaultSearch.setTranspositionTableSize(megabytes);
+}
+
+/**
+ * Sets the amount of threads of the search context of the whole process.
+ *
+ * @param threads - The amount of threads, including the main thread
+ */
+void setThreadCount(int threads)
+{
+	defaultSearch.setThreadCount(threads);
+}
+
+/**
+ * Sets the size of the first aspiration window of the search context of the whole process.
+ *
+ * @param size - The half width in percentage of the cells of the map
+ */
+void setWindowSize(double size)
+{
+	defaultSearch.setWindowSize(size);
+}
+
+/**
+ * Sets the depth below which the search context of the whole process skips the ply of the merged opponents.
+ *
+ * @param depth - The plies that have to be left for the merged ply to be searched
+ */
+void setCoalescingDepth(int depth)
+{
+	defaultSearch.setCoalescingDepth(depth);
+}
+
+uint64_t getNumberOfAnalyzedNodes()
+{
+	return defaultSearch.getNumberOfAnalyzedNodes();
+}
+
+long getTimeSpendEvaluating()
+{
+	return defaultSearch.getTimeSpendEvaluating();
+}
+
+uint64_t getTranspositionTableProbes()
+{
+	return defaultSearch.getTranspositionTableProbes();
+}
+
+uint64_t getTranspositionTableHits()
+{
+	return defaultSearch.getTranspositionTableHits();
+}
+
+uint64_t getTranspositionTableCollisions()
+{
+	return defaultSearch.getTranspositionTableCollisions();
+}
+
+WindowStatistics getWindowStatistics()
+{
+	return defaultSearch.getWindowStatistics();
+}
+
+uint64_t getCutoffs()
+{
+	return defaultSearch.getCutoffs();
+}
+
+uint64_t getFirstMoveCutoffs()
+{
+	return defaultSearch.getFirstMoveCutoffs();
+}
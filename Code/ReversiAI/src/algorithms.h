@@ -1,19 +1,285 @@
 #ifndef ALGORITHMS_H_
 #define ALGORITHMS_H_
 
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <vector>
 #include "map.h"
+#include "transposition.h"
+#include "workstealing.h"
+#include "timemanager.h"
 
 #define MINIMAX 1
 #define ALPHABETA 2
 #define ALPHABETA_MOVESORTING 3
 #define ASPIRATIONAL_WINDOW 4
+#define LAZY_SMP 5
+#define PARALLEL_ALPHABETA 6
+#define PRINCIPAL_VARIATION 7
+#define BEST_REPLY 8
+#define OPPONENT_COALESCING 9
 
-void initTimer();
+#define DEFAULT_WINDOW_SIZE 5 // The half width of the first aspiration window, in percentage of the cells
+#define DEFAULT_WINDOW_RESIZE 20 // The half width of the window after the first one failed, in percentage of the cells
+
+#define MAX_KILLER_PLY 128 // The plies below the root for which the move sorting keeps killer moves
+#define HISTORY_SLOTS 13 // The kinds of moves on a cell the history of the move sorting distinguishes, see getHistoryIndex()
+
+#define COALESCED_PLAYER 0 // The pseudo-player of OPPONENT_COALESCING, in whose ply the opponents merged into it move
+#define COALESCING_DISTANCE 4 // The steps from our stones beyond which an opponent counts as weakly interacting
+#define COALESCING_SHARE 25 // The percentage of the interaction of the most interacting opponent below which an opponent counts as weakly interacting
+#define DEFAULT_COALESCING_DEPTH 5 // The plies that have to be left for OPPONENT_COALESCING to search the ply of the merged opponents
+
+/**
+ * How well the aspiration windows of ASPIRATIONAL_WINDOW fitted the values of the iterations, over one search or a whole game.
+ * The score changes are given in the unit of the window sizes, so the average change is a hint for the window size of a map.
+ */
+typedef struct WindowStatistics
+{
+	int iterations;							///< The iterations searched with a window, the first one of a search has none
+	int failLows;							///< The searches whose value was not above their window
+	int failHighs;							///< The searches whose value was not below their window
+	uint64_t nodes;							///< The nodes of all iterations searched with a window
+	uint64_t failedNodes;					///< The nodes of the searches whose window failed
+	double scoreChangeSum;					///< The sum of the changes of the value between two iterations
+	int scoreChanges;						///< The amount of changes summed up, the ones from or to the end of the game are left out
+} WindowStatistics;
+
+/**
+ * The outcome of a search done by a SearchContext.
+ */
+typedef struct SearchResult
+{
+	Move move;								///< The best move found
+	int64_t score;							///< The value of the best move, as found by the last finished iteration
+	vector<Move> principalVariation;		///< The moves expected to follow, starting with the best move
+	int depth;								///< The depth of the last finished iteration
+	uint64_t nodesAnalyzed;					///< The nodes analysed by all threads of the search
+	long timeSpendEvaluating;				///< The time spend evaluating leafs in ms, only measured for benchmarking
+	uint64_t tableProbes;					///< The positions looked up in the transposition table
+	uint64_t tableHits;						///< The positions found in the transposition table
+	uint64_t tableCollisions;				///< The entries of the search replaced by another position
+	long deadlineOvershoot;					///< The time in us the search returned after its deadline, 0 if it was in time
+	WindowStatistics window;				///< The aspiration windows of the search, only used by ASPIRATIONAL_WINDOW
+	uint64_t cutoffs;						///< The nodes of the alphabeta and the move sorting cut off by one of their moves
+	uint64_t firstMoveCutoffs;				///< The cutoffs caused by the first move searched
+} SearchResult;
+
+/**
+ * A move of the root of the move sorting. Every iteration searches the root moves in the order of the values the
+ * former iteration found for them, so the list is sorted after every iteration.
+ */
+typedef struct RootMove
+{
+	Move move;
+	int64_t score;							///< The value of the move, only a bound if it did not raise alpha of the root
+	uint64_t nodes;							///< The nodes of the subtree of the move
+} RootMove;
+
+struct SplitPoint;
+
+/**
+ * Owns the state of the search for a move, so that several searches can run in one process without interfering.
+ * The threads of LAZY_SMP and PARALLEL_ALPHABETA use their own helper contexts, which share the stop flags and
+ * the transposition table of the context they help.
+ */
+class SearchContext
+{
+	public:
+		SearchContext();
+		~SearchContext();
+
+		SearchResult& search(Map& map, int searchDepth, int searchTime, uint8_t player, int algorithm, bool isPlayingPhase);
+		future<SearchResult&> searchAsync(Map& map, int searchDepth, int searchTime, uint8_t player, int algorithm, bool isPlayingPhase);
+		future<void> ponderAsync(Map& map, uint8_t lastPlayer, uint8_t player, int algorithm, bool isPlayingPhase);
+		future<void> analyseOpeningsAsync(Map& map, int algorithm, bool isPlayingPhase);
+		void stop();
+		void close();
+
+		void setTranspositionTableSize(int megabytes);
+		void setThreadCount(int threads);
+		void setWindowSize(double size);
+		void setCoalescingDepth(int depth);
+
+		// For benchmarking only!
+		uint64_t getNumberOfAnalyzedNodes();
+		long getTimeSpendEvaluating();
+		uint64_t getTranspositionTableProbes();
+		uint64_t getTranspositionTableHits();
+		uint64_t getTranspositionTableCollisions();
+		WindowStatistics getWindowStatistics();
+		uint64_t getCutoffs();
+		uint64_t getFirstMoveCutoffs();
+
+	private:
+		SearchResult result;
+
+		// Variables for benchmarking tests
+		struct timespec spec;
+		long timeSpendEvaluating;
+		long startTime,endTime;
+		uint64_t nodesAnalyzed;
+
+		// The state of the search
+		int currentChoice;
+		int currentCell;
+		int initialDepth;
+		int nextPlayer;
+		int64_t score;
+		int numberOfRepeatings;
+
+		int numberOfPlayers;
+		int playerID;
+
+		// Set once the search has to return, either by stop() or by the thread that noticed that the deadline has passed
+		atomic<bool> hasTimePassed;
+
+		// The time at which the search has to return
+		chrono::steady_clock::time_point deadline;
+
+		// The checks of the stop flag since the clock was read the last time
+		int timeCheckCount;
+
+		// Decides whether the next iteration is started, based on the nodes and times of the iterations so far
+		TimeManager timeManager;
+		uint64_t iterationStartNodes;
+
+		// Buffer for the cells recoloured by a move, shared by all nodes as every move uses it only while it is executed
+		vector<uint16_t> captureBuffer;
+
+		// The amount of threads used by LAZY_SMP and PARALLEL_ALPHABETA, including the thread of this context
+		int threadCount;
+
+		// The context whose search is helped, this context itself if it is not a helper
+		SearchContext* mainSearch;
+
+		// Set by the main context of LAZY_SMP when its search is done, to stop the helper threads
+		atomic<bool> areHelpersStopped;
+
+		// The nodes analysed by the helper threads of the last search
+		atomic<uint64_t> helperNodesAnalyzed;
+
+		// The table of this context and the one used by the search, which is the one of the main context
+		TranspositionTable transpositionTable;
+		TranspositionTable* table;
+
+		// Added to the hash keys of the positions, as the ratings depend on the player for whom the search is done
+		uint64_t rootPlayerKey;
+
+		// The threads of PARALLEL_ALPHABETA and the contexts the threads except for the first one search with
+		unique_ptr<WorkStealingPool> searchPool;
+		vector<unique_ptr<SearchContext> > workerSearches;
+
+		// The half widths of the aspiration windows in percentage of the cells, and the windows of all searches of the game
+		double windowSize;
+		double windowResize;
+		WindowStatistics gameWindows;
+
+		// The move ordering of the nodes of the move sorting below the root: the last two moves of every ply that caused a
+		// cutoff, and for every player, cell and kind of move the sum of the squared depths of the cutoffs it caused
+		Move killerMoves[MAX_KILLER_PLY][2];
+		vector<uint32_t> history;
+		uint64_t cutoffCount;
+		uint64_t firstMoveCutoffCount;
+
+		// Whether the move sorting searches the younger brothers with a null window first, as done by PRINCIPAL_VARIATION
+		bool isScouting;
+
+		// Whether the root is searched by the best-reply search and the opponents replying in it
+		bool isBestReply;
+		uint8_t opponents[MAX_PLAYER];
+		int opponentCount;
+
+		// Whether the move sorting merges the weakly interacting opponents into the ply of COALESCED_PLAYER, the merged
+		// opponents, the player following every player in the turn order of the search and the depth below which the
+		// ply of the merged opponents is skipped
+		bool isCoalescing;
+		uint8_t coalescedPlayers[MAX_PLAYER];
+		int coalescedCount;
+		uint8_t coalescedOrder[MAX_PLAYER+1];
+		int coalescingDepth;
+
+		// The moves of every ply in which several players move, for the best-reply search and the merged opponents
+		vector<vector<Move> > replyBuffers;
+
+		// Whether the search of PARALLEL_ALPHABETA considers override stones, the threads of the pool and pondering take it over
+		bool isConsideringOverrideStones;
+
+		// The copies of the positions of the split points currently owned by this context
+		vector<unique_ptr<Map> > splitMaps;
+		size_t splitMapCount;
+
+		// The map on which a thread of the pool searches the moves it stole
+		unique_ptr<Map> stolenMoveMap;
+
+		void startHelping(SearchContext& main);
+		void ponder(Map& map, uint8_t lastPlayer, uint8_t player, int algorithm, bool isPlayingPhase);
+		void startPonderingRoutine(Map& map, int algorithm);
+		uint8_t prepareTurnOrder(Map& map, uint8_t lastPlayer, uint8_t player, int algorithm, bool isPlayingPhase);
+		void ponderDepth(Map& map, uint8_t turn, int depth, int algorithm, bool isPlayingPhase);
+		void analyseOpenings(Map& map, int algorithm, bool isPlayingPhase);
+		void setRootPlayer(uint8_t player);
+		void startSearchPool();
+		void setDeadline(Map& map, bool isPlayingPhase, int searchTime);
+		void startIteration();
+		void finishIteration(int depth);
+		void abortIteration(int depth);
+		bool hasTimeRunOut();
+		bool isNextIterationAffordable();
+		void setBestMove(Map& map, int depth, int64_t value);
+		void updateBestMove(uint16_t cell, char choice, int64_t* best);
+		void addScoreChange(Map& map, int64_t lastScore, int64_t value);
+		void reportWindows(WindowStatistics& windows);
+		void startMoveOrdering(Map& map);
+		int getHistoryIndex(Map& map, uint8_t player, Move& move, bool isPlayingPhase);
+		void rateMoves(Map& map, int ply, MoveList& moves, TranspositionEntry& entry, uint32_t* ratings, bool isPlayingPhase);
+		void recordCutoff(Map& map, int ply, int depth, Move& move, bool isFirstMove, bool isPlayingPhase);
+		void collectPrincipalVariation(Map& map, uint8_t player, bool isPlayingPhase);
+		void sortRootMoves(vector<RootMove>& rootMoves);
+		void coalesceOpponents(Map& map, uint8_t player, bool isPlayingPhase);
+		uint8_t getNextSearchedPlayer(Map& map, uint8_t player, int currentDepth);
+		MoveList generateMergedMoves(Map& map, int ply, const uint8_t* players, int playerCount, bool isPlayingPhase);
+		int64_t moveSorting_firstIte(Map& map, uint8_t turn, vector<RootMove>& rootMoves, bool isPlayingPhase);
+		int64_t moveSorting(Map& map, uint8_t player, int currentDepth, int64_t alpha, int64_t beta, vector<RootMove>* rootMoves, bool isPlayingPhase);
+		int64_t searchRoot(Map& map, uint8_t player, int64_t alpha, int64_t beta, vector<RootMove>& rootMoves, bool isPlayingPhase);
+		int64_t bestReply(Map& map, int currentDepth, int64_t alpha, int64_t beta, bool isReplying, bool hasPassed, bool isPlayingPhase);
+		int64_t searchChild(Map& map, uint8_t player, int currentDepth, int64_t alpha, int64_t beta, bool isMaximizer, bool& isFirstChild, bool isPlayingPhase);
+		int64_t alphabeta(Map& map, uint8_t turn, int depth, bool isPlayingPhase, int64_t alpha, int64_t beta);
+		int64_t minimax(Map& map, uint8_t turn, int depth, bool isPlayingPhase);
+		int64_t parallelAlphabeta(Map& map, uint8_t turn, int depth, bool isPlayingPhase, int64_t alpha, int64_t beta, int passes, SplitPoint* parentSplit);
+		void searchSplitMove(Map& map, SplitPoint* split, int index);
+		static void searchStolenMove(void* data, int index);
+		void searchAsHelper(Map* map, int helperIndex, int searchDepth, uint8_t player, bool isPlayingPhase, bool toConsiderOverrideStones, vector<RootMove> rootMoves);
+		bool probeTranspositionTable(uint64_t key, int depth, int64_t alpha, int64_t beta, TranspositionEntry& entry);
+		void storeTranspositionEntry(uint64_t key, int depth, int64_t alpha, int64_t beta, int64_t value, Move* move);
+		bool isSearchStopped();
+		uint8_t getNextActivePlayer(Map& map, uint8_t turn);
+		void startTimer();
+		void endTimer();
+};
+
+// Functions using one search context for the whole process
 Move* getNextMove(Map& map, int searchDepth, int searchTime, uint8_t player, int algorithm, bool isPlayingPhase);
+future<SearchResult&> searchNextMoveAsync(Map& map, int searchDepth, int searchTime, uint8_t player, int algorithm, bool isPlayingPhase);
+future<void> ponderAsync(Map& map, uint8_t lastPlayer, uint8_t player, int algorithm, bool isPlayingPhase);
+future<void> analyseOpeningsAsync(Map& map, int algorithm, bool isPlayingPhase);
+void stopSearching();
 void close();
+void setTranspositionTableSize(int megabytes);
+void setThreadCount(int threads);
+void setWindowSize(double size);
+void setCoalescingDepth(int depth);
 
 // For benchmarking only!
 uint64_t getNumberOfAnalyzedNodes(void);
 long getTimeSpendEvaluating(void);
+uint64_t getTranspositionTableProbes(void);
+uint64_t getTranspositionTableHits(void);
+uint64_t getTranspositionTableCollisions(void);
+WindowStatistics getWindowStatistics(void);
+uint64_t getCutoffs(void);
+uint64_t getFirstMoveCutoffs(void);
 
 #endif /* ALGORITHMS_H_ */
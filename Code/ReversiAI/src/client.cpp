@@ -335,6 +335,10 @@ void sendMessage(uint8_t type, uint32_t length, uint8_t* message)
 			cout << "G3-Error: No more bytes can be transferred!" << endl;
 			return;
 		}
+		else if (sendStatus == -1 && errno == EINTR)	// interrupted before anything was send
+		{
+			continue;
+		}
 		else if (sendStatus == -1)
 		{
 			cout << "G3-Error: " << errno << endl;
@@ -366,6 +370,10 @@ void readMessage(int32_t length, char* message){
             cout << "G3-Error: No more bytes to read!" << endl;
             return;
         }
+        else if (readStatus == -1 && errno == EINTR)	// interrupted before anything was read
+        {
+        	continue;
+        }
         else if (readStatus == -1)
         {
         	cout << "G3-Error: " << errno << endl;
@@ -18,6 +18,11 @@
 #include <queue>
 #include <cstdint>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RAY_GATHER		// The first cells of all rays of a cell can be checked at once with AVX2 gathers
+#include <immintrin.h>
+#endif
+
 #include "map.h"
 #include "weights.h"
 
@@ -28,62 +33,126 @@ using namespace std;
 //TODO adjust weights
 //TODO profile
 
-int freeCells;
-int width;
-int height;
-int lineCount;
-int cellcount;
-int bombExplosionRadius;
-int amountOfPlayers;
-int amountOfActivePlayers;
+// Every search thread decides on its own whether it considers override stones
+thread_local bool toConsiderOverrideStones=true;
+
+// The amount of cells at the start of every ray that are checked at once, longer rays are continued one by one
+#define RAY_PREFIX_LENGTH 4
+
+// Zero bytes behind the cells of a board. The first one ends the shorter rays in rayPrefix,
+// the others allow reading it as a 32 bit word.
+#define BOARD_PADDING 4
+
+// The amount of different states a cell can have: empty, the players, the special cells and holes
+#define ZOBRIST_STATE_COUNT (MAX_PLAYER+6)
 
-vector<uint8_t> nextPlayers;
+// The kinds of information that are mixed into the hash keys
+#define ZOBRIST_CELL 0
+#define ZOBRIST_PLAYER_MAP 1
+#define ZOBRIST_STONE_COUNT 2
+#define ZOBRIST_TURN 3
+#define ZOBRIST_PHASE 4
+#define ZOBRIST_OVERRIDE 5
+#define ZOBRIST_TURN_ORDER 6
+#define ZOBRIST_DISQUALIFIED 7
 
-bool toConsiderOverrideStones=true;
+// Slots of the bitboards that are only stored in the compacted cell order (behind the rotated ones)
+#define EMPTY_CELLS 0
+#define SPECIAL_CELLS 1
+#define HOLE_CELLS 2
+#define CANDIDATE_CELLS 3
+#define COMPACTED_SLOT_COUNT 4
+
+// The orientation in which the bit position is equal to the compacted cell index
+#define HORIZONTAL 2
+
+const int directionX[DIRECTION_COUNT] = { 0, 1, 1, 1, 0,-1,-1,-1};
+const int directionY[DIRECTION_COUNT] = {-1,-1, 0, 1, 1, 1, 0,-1};
 
 /**
- * Contains the offset of the cells on the board (in class Map) and existentCell to the right cell.
+ * Returns the random key for one value of a kind of information, which is used for the hash keys.
+ * The keys are taken from the SplitMix64 generator, so that they are the same in every run.
+ *
+ * @param kind  - The kind of the information, one of the ZOBRIST_ defines
+ * @param value - The value of the information
+ * @return The key of that value
  */
-int offsetMap[MAX_WIDTH][MAX_HEIGHT];
+inline uint64_t getZobristKey(uint32_t kind, uint32_t value)
+{
+	uint64_t key = (((uint64_t)kind<<32) | value) * 0x9E3779B97F4A7C15ULL;
+	key = (key ^ (key>>30)) * 0xBF58476D1CE4E5B9ULL;
+	key = (key ^ (key>>27)) * 0x94D049BB133111EBULL;
+	return key ^ (key>>31);
+}
 
 /**
- * Contains the x coordinate of the cell that is at offset position in the array.
+ * Returns whether a direction walks towards higher bit positions in the rotated bitboards.
+ *
+ * @param dir - The direction that should be checked
+ * @return True for the directions east, south east, south and south west, false otherwise
  */
-int reverseOffsetX[MAX_WIDTH * MAX_HEIGHT];
+inline bool isForwardDirection(uint8_t dir)
+{
+	return (2<=dir) && (dir<=5);
+}
 
 /**
- * Contains the y coordinate of the cell that is at offset position in the array.
+ * Returns whether a ray of the moving player stops at a cell in the given state.
+ * Rays stop at own stones and at cells that can not be captured (empty, choice, inversion and bonus cells).
+ *
+ * @param state  - The state of the cell
+ * @param colour - The colour of the stones of the player that is moving
+ * @return True if the ray ends at that cell, false if it can continue over it
  */
-int reverseOffsetY[MAX_WIDTH * MAX_HEIGHT];
+inline bool isRayEnd(char state, char colour)
+{
+	return state==colour || state==0 || state=='c' || state=='b' || state=='i';
+}
 
 /**
- * Contains a list of the players that got disqualified.
+ * Returns whether a cell in the given state holds a stone, which can be captured or overridden.
+ *
+ * @param state - The state of the cell
+ * @return True for the stones of all players and expansion stones, false otherwise
  */
-bool disqualified[MAX_PLAYER+1];
+inline bool isStone(char state)
+{
+	return (state>0 && state<=MAX_PLAYER) || state=='x';
+}
 
 /**
- * Contains all information regarding neighbours and their direction of the cells on the board.
- * Slots correlate with the board in the class Map.
+ * Checks whether the processor supports AVX2, so that the rays can be checked with gathers.
+ *
+ * @return True if MapTopology::hasCapturesGathered can be used, false otherwise
  */
-Cell* existentCell;
+bool checkRayGatherSupport()
+{
+#ifdef RAY_GATHER
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
 
-vector<int>* cellsOnLine;
+/**
+ * True if the processor supports AVX2, so that the rays can be checked with gathers.
+ */
+const bool isRayGatherSupported = checkRayGatherSupport();
 
-////////////////////////////////////////
-////			     				////
-////  PUBLIC METHODES OF MAP CLASS  ////
-////                    			////
-////////////////////////////////////////
+/////////////////////////////////////////////
+////			     						 ////
+////  METHODES OF MAP TOPOLOGY CLASS     ////
+////                    				 ////
+/////////////////////////////////////////////
 
 /**
- * Constructor for a map instance for reading a map from a text file or the server. 
- * This should always be used for the initial construction of a map. 
- * The default constructor should only be used if another map will
- * be copied into it via the copy() function.
+ * Parses a map from a text file or the server and builds everything that does not change during a game.
+ * The start position of the map is kept, so that every Map created from this topology begins with it.
  *
  * @param is - A reference to a byte stream which contains the information of a map
  */
-Map::Map(istream& is)
+MapTopology::MapTopology(istream& is)
 {
 	/** 
 	* This char array will be used to read the numbers in as string and will then 
@@ -96,13 +165,12 @@ Map::Map(istream& is)
 	// Parse the basic settings for the map
 	is.getline(s_currentNumber,bufferSize);
 	istringstream (s_currentNumber) >> amountOfPlayers;
-	amountOfActivePlayers = amountOfPlayers;
 
 	is.getline(s_currentNumber,bufferSize);
-	istringstream (s_currentNumber) >> overrideStones[1];
+	istringstream (s_currentNumber) >> startOverrideStones;
 
 	is.getline(s_currentNumber,bufferSize,' ');
-	istringstream (s_currentNumber) >> numberOfBombs[1];
+	istringstream (s_currentNumber) >> startBombs;
 
 
 
@@ -115,43 +183,20 @@ Map::Map(istream& is)
 	is.getline(s_currentNumber,bufferSize);
 	istringstream (s_currentNumber) >> width;
 
-	// Initialize the override stone and bomb count for every player.
-	// At the same time initialize the player map and the disqualification array
-	disqualified[0] = true;
-	playerMap[0] = 0;	// Zero will always map to itself
-
-	for(int p=1; p<=MAX_PLAYER; ++p)
-	{
-		if(p <= getAmountOfPlayers())
-		{
-			overrideStones[p] = overrideStones[1];
-			numberOfBombs[p] = numberOfBombs[1];
-			playerMap[p] = p;
-			disqualified[p] = false;
-		}
-		else
-		{
-			playerMap[p] = NO_PLAYER; // Mark player as 'not a player'
-			disqualified[p] = true;
-		}
-	}
-
 	/**
 	* We only want to keep the cells in our array and discard all the holes.
 	* To avoid having to reopen the map after counting the amount of cells,
 	* we save everything into an temporary array. As we do not need to know 
 	* the amount of cells to know the offsets, we initialize the array right away.
 	*/
-	char boardstate[getWidth()][getHeight()];
+	char boardstate[width][height];
 
 	cellcount=0; // Save the number of cells needed
-	amountOfInversionStones=0;
-	amountOfChoiceStones=0;
 	char c=0;
 
-	for(int y = 0; y < getHeight(); ++y)
+	for(int y = 0; y < height; ++y)
 	{
-		for(int x = 0; x < getWidth(); ++x)
+		for(int x = 0; x < width; ++x)
 		{
 			c = is.get();
 
@@ -184,15 +229,14 @@ Map::Map(istream& is)
 		}
 	}
 
-	// Create board and transition map (existentCell), now that the size is known
-	board = new char[getAmountOfCells()];
-	existentCell = new Cell[getAmountOfCells()];
-	isStoneStable = new bool[LINE_COUNT*getAmountOfCells()];
+	// Create the start board and transition map (existentCell), now that the size is known
+	startBoard = new char[cellcount];
+	existentCell = new Cell[cellcount];
 
 	// Now we get to the fun part! You should grab a coffee.. two might be better ;)
 
 	// Initialize every neighbour to be non existent
-	for(int cell=0; cell<getAmountOfCells(); ++cell)
+	for(int cell=0; cell<cellcount; ++cell)
 	{
 		for(uint8_t dir=0; dir<DIRECTION_COUNT; ++dir)
 		{
@@ -202,21 +246,21 @@ Map::Map(istream& is)
 	}
 
 	// Copy the states of the cells into our array that has minimal size
-	for(uint32_t y=0; y<getHeight(); ++y)
+	for(uint32_t y=0; y<height; ++y)
 	{
-		for(uint32_t x=0; x<getWidth(); ++x)
+		for(uint32_t x=0; x<width; ++x)
 		{
 			if(offsetMap[x][y] != NO_CELL)
 			{
-				board[getOffset(x,y)] = boardstate[x][y];
+				startBoard[offsetMap[x][y]] = boardstate[x][y];
 			}
 		}
 	}
 
 	// Add all trivial neighbours that are given by direct neighbourhood
-	for(uint32_t x = 0; x < getWidth(); x++)
+	for(uint32_t x = 0; x < width; x++)
 	{
-		for(uint32_t y = 0; y < getHeight(); y++)
+		for(uint32_t y = 0; y < height; y++)
 		{
 			if(offsetMap[x][y] != NO_CELL)
 			{
@@ -224,23 +268,23 @@ Map::Map(istream& is)
 				{
 					addNeighbour(x, y, 0, x, y-1, 4);
 				}
-				if(x+1 < getWidth() && y > 0 && offsetMap[x+1][y-1] != NO_CELL)
+				if(x+1 < width && y > 0 && offsetMap[x+1][y-1] != NO_CELL)
 				{
 					addNeighbour(x, y, 1, x+1, y-1, 5);
 				}
-				if(x+1 < getWidth() && offsetMap[x+1][y] != NO_CELL)
+				if(x+1 < width && offsetMap[x+1][y] != NO_CELL)
 				{
 					addNeighbour(x, y, 2, x+1, y, 6);
 				}
-				if(x+1 < getWidth() && y+1 < getHeight() && offsetMap[x+1][y+1] != NO_CELL)
+				if(x+1 < width && y+1 < height && offsetMap[x+1][y+1] != NO_CELL)
 				{
 					addNeighbour(x, y, 3, x+1, y+1, 7);
 				}
-				if(y+1 < getHeight() && offsetMap[x][y+1] != NO_CELL)
+				if(y+1 < height && offsetMap[x][y+1] != NO_CELL)
 				{
 					addNeighbour(x, y, 4, x, y+1, 0);
 				}
-				if(x > 0 && y+1 < getHeight() && offsetMap[x-1][y+1] != NO_CELL)
+				if(x > 0 && y+1 < height && offsetMap[x-1][y+1] != NO_CELL)
 				{
 					addNeighbour(x, y, 5, x-1, y+1, 1);
 				}
@@ -271,9 +315,9 @@ Map::Map(istream& is)
 	// Set the line index for the horizontal lines
 	int index=-1;
 	bool nextIsNew=true;
-	for(int y=0; y<getHeight(); ++y)
+	for(int y=0; y<height; ++y)
 	{
-		for(int x=0; x<getWidth(); ++x)
+		for(int x=0; x<width; ++x)
 		{
 			int offset = offsetMap[x][y];
 
@@ -297,9 +341,9 @@ Map::Map(istream& is)
 
 	// Set the line index for the vertical lines
 	nextIsNew=true;
-	for(int x=0; x<getWidth(); ++x)
+	for(int x=0; x<width; ++x)
 	{
-		for(int y=0; y<getWidth(); ++y)
+		for(int y=0; y<width; ++y)
 		{
 			int offset = offsetMap[x][y];
 
@@ -323,12 +367,12 @@ Map::Map(istream& is)
 
 	// Set the line index for the anti-diagonals
 	nextIsNew=true;
-	for(int i=0; i<getWidth(); ++i)
+	for(int i=0; i<width; ++i)
 	{
 		int x=i;
 		int y=0;
 
-		while((x>=0) && (y<getHeight()))
+		while((x>=0) && (y<height))
 		{
 			int offset = offsetMap[x][y];
 
@@ -355,12 +399,12 @@ Map::Map(istream& is)
 	}
 
 	nextIsNew=true;
-	for(int i=1; i<getHeight(); ++i)
+	for(int i=1; i<height; ++i)
 	{
-		int x=getWidth()-1;
+		int x=width-1;
 		int y=i;
 
-		while((y<getHeight()) && (x>=0))
+		while((y<height) && (x>=0))
 		{
 			int offset = offsetMap[x][y];
 
@@ -388,12 +432,12 @@ Map::Map(istream& is)
 
 	// Set the line index for the diagonals
 	nextIsNew=true;
-	for(int i=getHeight(); i>=0; --i)
+	for(int i=height; i>=0; --i)
 	{
 		int x=0;
 		int y=i;
 
-		while((x<getWidth()) && (y<getHeight()))
+		while((x<width) && (y<height))
 		{
 			int offset = offsetMap[x][y];
 
@@ -420,12 +464,12 @@ Map::Map(istream& is)
 	}
 
 	nextIsNew=true;
-	for(int i=1; i<getWidth(); ++i)
+	for(int i=1; i<width; ++i)
 	{
 		int x=i;
 		int y=0;
 
-		while((y<getHeight()) && (x<getWidth()))
+		while((y<height) && (x<width))
 		{
 			int offset = offsetMap[x][y];
 
@@ -489,8 +533,8 @@ Map::Map(istream& is)
 		}
 
 		// Check if the new lines have to merged with other ones or only with themselves for the moment
-		int first = existentCell[getOffset(x1,y1)].lineIndex[dir1%LINE_COUNT];
-		int second = existentCell[getOffset(x2,y2)].lineIndex[dir2%LINE_COUNT];
+		int first = existentCell[offsetMap[x1][y1]].lineIndex[dir1%LINE_COUNT];
+		int second = existentCell[offsetMap[x2][y2]].lineIndex[dir2%LINE_COUNT];
 		bool hasAdded=false;
 		for(vector<vector<int> >::iterator it=toMerge.begin(); it!=toMerge.end(); ++it) {
 			// If the first element is already in a list, add the second as well
@@ -542,7 +586,7 @@ Map::Map(istream& is)
 			{
 				int line=*listIt;
 				// Iterate over all elements on line
-				for(int cell=0; cell<getAmountOfCells(); ++cell)
+				for(int cell=0; cell<cellcount; ++cell)
 				{
 					for(int d=0; d<4; ++d)
 					{
@@ -571,13 +615,11 @@ Map::Map(istream& is)
 	lineCount=(index+1)-toDelete.size();
 
 	cellsOnLine = new vector<int>[lineCount];
-	amountOfFreeCellsOnLine = new uint16_t[lineCount];
-	memset(amountOfFreeCellsOnLine,0,lineCount*sizeof(uint16_t));
 
 	// Correct the offset errors created by deleting unused lines
 	for(int del=toDelete.size()-1; 0<=del; --del)
 	{
-		for(int cell=0; cell<getAmountOfCells(); ++cell)
+		for(int cell=0; cell<cellcount; ++cell)
 		{
 			for(int dir=0; dir<LINE_COUNT; ++dir)
 			{
@@ -591,7 +633,7 @@ Map::Map(istream& is)
 
 	// As the line indices are now correct for every cell, we can use that information
 	// to initialize the counters and list of cells for every line
-	for(int cell=0; cell<getAmountOfCells(); ++cell)
+	for(int cell=0; cell<cellcount; ++cell)
 	{
 		set<int> index;
 		for(int dir=0; dir<4; ++dir)
@@ -603,79 +645,253 @@ Map::Map(istream& is)
 		for(set<int>::iterator it=index.begin(); it!=index.end(); ++it)
 		{
 			cellsOnLine[*it].push_back(cell);
-			if(board[cell]<1 || (board[cell]>MAX_PLAYER && board[cell]!='x') )
+		}
+	}
+
+	/**
+	* For the bitboards every line orientation gets its own order of the cells, so that the cells
+	* of a line are stored on neighbouring bits. The horizontal lines already have that order,
+	* the vertical lines are ordered by column, and the (anti-)diagonals from the top to the bottom.
+	* Following a line towards east, south east, south or south west increases the bit position.
+	*/
+	bitboardWordCount = (cellcount+63)/64;
+
+	for(int orientation=0; orientation<LINE_COUNT; ++orientation)
+	{
+		cellToBit[orientation] = new uint16_t[cellcount];
+		bitToCell[orientation] = new uint16_t[cellcount];
+	}
+
+	for(int cell=0; cell<cellcount; ++cell)
+	{
+		cellToBit[HORIZONTAL][cell] = cell;
+	}
+
+	int bit=0;
+	for(int x=0; x<width; ++x)
+	{
+		for(int y=0; y<height; ++y)
+		{
+			if(offsetMap[x][y] != NO_CELL)
 			{
-				amountOfFreeCellsOnLine[*it]++;
+				cellToBit[0][offsetMap[x][y]] = bit++;
 			}
 		}
 	}
 
-	// Set the base stability for every cell (=stability given by holes as direct neighbours)
-	// This is used to avoid placing a stone near to corners or walls
-	int stability[getAmountOfCells()];
-	memset(stability, 0, getAmountOfCells()*sizeof(int));
-
-	for(int cell=0; cell<getAmountOfCells(); ++cell)
+	bit=0;
+	for(int sum=0; sum<width+height-1; ++sum)
 	{
-		for(int dir=0; dir<4; ++dir)
+		for(int y=0; y<height; ++y)
 		{
-			if((existentCell[cell].neighbour[dir]==NO_CELL) || (existentCell[cell].neighbour[dir+4]==NO_CELL))
+			int x = sum-y;
+			if(0<=x && x<width && offsetMap[x][y] != NO_CELL)
 			{
-				stability[cell]++;
-				isStoneStable[4*cell+dir]=true;
+				cellToBit[1][offsetMap[x][y]] = bit++;
 			}
-			else if(amountOfFreeCellsOnLine[existentCell[cell].lineIndex[dir]]==0)
+		}
+	}
+
+	bit=0;
+	for(int difference=1-height; difference<width; ++difference)
+	{
+		for(int y=0; y<height; ++y)
+		{
+			int x = y+difference;
+			if(0<=x && x<width && offsetMap[x][y] != NO_CELL)
 			{
-				isStoneStable[4*cell+dir]=true;
+				cellToBit[3][offsetMap[x][y]] = bit++;
 			}
-			else
+		}
+	}
+
+	for(int orientation=0; orientation<LINE_COUNT; ++orientation)
+	{
+		for(int cell=0; cell<cellcount; ++cell)
+		{
+			bitToCell[orientation][cellToBit[orientation][cell]] = cell;
+		}
+	}
+
+	// Mark for every direction which bits are reached from the neighbouring bit with a trivial step
+	for(int dir=0; dir<DIRECTION_COUNT; ++dir)
+	{
+		lineContinuation[dir] = new uint64_t[bitboardWordCount];
+		memset(lineContinuation[dir], 0, bitboardWordCount*sizeof(uint64_t));
+
+		for(int cell=0; cell<cellcount; ++cell)
+		{
+			if(isTrivialStep(cell, dir))
 			{
-				isStoneStable[4*cell+dir]=false;
+				int target = cellToBit[dir%LINE_COUNT][existentCell[cell].neighbour[dir]];
+				lineContinuation[dir][target>>6] |= (uint64_t)1 << (target&63);
 			}
 		}
 	}
 
-	for(int cell=0; cell<getAmountOfCells(); ++cell)
+	/**
+	* Follow every ray once and store its cells, so that the capture checks can scan them linearly
+	* instead of looking up the neighbour and the new direction at every step.
+	* At the same time remember the cells whose rays continue through transitions.
+	*/
+	vector<uint16_t> rays;
+	rayBegin = new uint32_t[DIRECTION_COUNT*cellcount+1];
+	transitionCells = new uint64_t[bitboardWordCount];
+	memset(transitionCells, 0, bitboardWordCount*sizeof(uint64_t));
+
+	for(int cell=0; cell<cellcount; ++cell)
 	{
-		for(int dir=0; dir<8; ++dir)
+		for(int dir=0; dir<DIRECTION_COUNT; ++dir)
 		{
-			if(existentCell[cell].neighbour[dir]!=NO_CELL)
+			rayBegin[DIRECTION_COUNT*cell+dir] = rays.size();
+
+			uint16_t prevCell = cell;
+			uint8_t prevDirection = dir;
+			uint16_t curCell = existentCell[cell].neighbour[dir];
+
+			// A ray can only come back to its start cell, the limit just protects against broken transitions
+			while(curCell != NO_CELL && curCell != cell && rays.size()-rayBegin[DIRECTION_COUNT*cell+dir] < (unsigned int)DIRECTION_COUNT*cellcount)
 			{
-				existentCell[cell].baseStability[dir]=stability[existentCell[cell].neighbour[dir]];
+				if(!isTrivialStep(prevCell, prevDirection))
+				{
+					transitionCells[cell>>6] |= (uint64_t)1 << (cell&63);
+				}
+
+				rays.push_back(curCell);
+
+				prevDirection = existentCell[prevCell].direction[prevDirection];
+				prevCell = curCell;
+				curCell = existentCell[prevCell].neighbour[prevDirection];
 			}
-			else
+		}
+	}
+
+	rayBegin[DIRECTION_COUNT*cellcount] = rays.size();
+
+	rayPrefix = new int32_t[cellcount*RAY_PREFIX_LENGTH*DIRECTION_COUNT];
+	for(int cell=0; cell<cellcount; ++cell)
+	{
+		for(int dir=0; dir<DIRECTION_COUNT; ++dir)
+		{
+			uint32_t first = rayBegin[DIRECTION_COUNT*cell+dir];
+			uint32_t length = rayBegin[DIRECTION_COUNT*cell+dir+1] - first;
+
+			for(uint32_t step=0; step<RAY_PREFIX_LENGTH; ++step)
 			{
-				existentCell[cell].baseStability[dir]=0;
+				rayPrefix[(cell*RAY_PREFIX_LENGTH + step)*DIRECTION_COUNT + dir] = (step<length) ? rays[first+step] : cellcount;
 			}
 		}
 	}
 
-	//Set the amount of likely reachable inversion and choice stones
-	for(uint16_t cell=0; cell<getAmountOfCells(); ++cell)
+	maximumCaptureCount=1;
+	for(int cell=0; cell<cellcount; ++cell)
 	{
-		if(getState(cell)=='i')
+		int rayLength = rayBegin[DIRECTION_COUNT*(cell+1)] - rayBegin[DIRECTION_COUNT*cell];
+		maximumCaptureCount = max(maximumCaptureCount, rayLength);
+	}
+	rayCells = new uint16_t[rays.size()];
+	std::copy(rays.begin(), rays.end(), rayCells);
+
+	// Invert the neighbour relation, as transitions can make it one-sided
+	linkingBegin = new uint32_t[cellcount+1];
+	memset(linkingBegin, 0, (cellcount+1)*sizeof(uint32_t));
+
+	for(int cell=0; cell<cellcount; ++cell)
+	{
+		for(int dir=0; dir<DIRECTION_COUNT; ++dir)
 		{
-			if(isStoneReachable(cell))
+			if(existentCell[cell].neighbour[dir]!=NO_CELL)
 			{
-				amountOfInversionStones++;
+				linkingBegin[existentCell[cell].neighbour[dir]+1]++;
 			}
 		}
-		else if(getState(cell)=='c')
+	}
+	for(int cell=0; cell<cellcount; ++cell)
+	{
+		linkingBegin[cell+1] += linkingBegin[cell];
+	}
+
+	linkingCells = new uint16_t[linkingBegin[cellcount]];
+	uint32_t linkCount[cellcount];
+	memset(linkCount, 0, cellcount*sizeof(uint32_t));
+
+	for(int cell=0; cell<cellcount; ++cell)
+	{
+		for(int dir=0; dir<DIRECTION_COUNT; ++dir)
 		{
-			if(isStoneReachable(cell))
+			uint16_t neighbour = existentCell[cell].neighbour[dir];
+			if(neighbour!=NO_CELL)
 			{
-				amountOfChoiceStones++;
+				linkingCells[linkingBegin[neighbour] + linkCount[neighbour]++] = cell;
 			}
 		}
 	}
 
-	cout << "Amount of reachable inversion stones: "<< amountOfInversionStones<<endl;
-	cout << "Amount of reachable choice stones: "<< amountOfChoiceStones<<endl;
+	// Number the states of a cell and give every state of every cell its key
+	memset(zobristState, 0, sizeof(zobristState));
+	for(int state=0; state<=MAX_PLAYER; ++state)
+	{
+		zobristState[state] = state;
+	}
+	zobristState[(int)'c'] = MAX_PLAYER+1;
+	zobristState[(int)'b'] = MAX_PLAYER+2;
+	zobristState[(int)'i'] = MAX_PLAYER+3;
+	zobristState[(int)'x'] = MAX_PLAYER+4;
+	zobristState[NO_STONE] = MAX_PLAYER+5;
+
+	zobristKeys = new uint64_t[cellcount*ZOBRIST_STATE_COUNT];
+	for(int i=0; i<cellcount*ZOBRIST_STATE_COUNT; ++i)
+	{
+		zobristKeys[i] = getZobristKey(ZOBRIST_CELL, i);
+	}
+
+	maximumMoveCount=cellcount;
+	for(int cell=0; cell<cellcount; ++cell)
+	{
+		if(startBoard[cell]=='c')
+		{
+			maximumMoveCount += amountOfPlayers-1;
+		}
+		else if(startBoard[cell]=='b')
+		{
+			maximumMoveCount++;
+		}
+	}
+
+	// Set the base stability for every cell (=stability given by holes as direct neighbours)
+	// This is used to avoid placing a stone near to corners or walls
+	int stability[cellcount];
+	memset(stability, 0, cellcount*sizeof(int));
+
+	for(int cell=0; cell<cellcount; ++cell)
+	{
+		for(int dir=0; dir<4; ++dir)
+		{
+			if((existentCell[cell].neighbour[dir]==NO_CELL) || (existentCell[cell].neighbour[dir+4]==NO_CELL))
+			{
+				stability[cell]++;
+			}
+		}
+	}
 
+	for(int cell=0; cell<cellcount; ++cell)
+	{
+		for(int dir=0; dir<8; ++dir)
+		{
+			if(existentCell[cell].neighbour[dir]!=NO_CELL)
+			{
+				existentCell[cell].baseStability[dir]=stability[existentCell[cell].neighbour[dir]];
+			}
+			else
+			{
+				existentCell[cell].baseStability[dir]=0;
+			}
+		}
+	}
 
 	//Set the influence of every cell to the amount of stones that are on the same lines
 	int totalInfluence=0;
-	for(uint16_t cell=0; cell<getAmountOfCells(); ++cell)
+	for(uint16_t cell=0; cell<cellcount; ++cell)
 	{
 		int sum=0;
 		for(int d=0; d<LINE_COUNT; ++d)
@@ -687,10 +903,10 @@ Map::Map(istream& is)
 		existentCell[cell].influence=sum-3;
 	}
 
-	WEIGHT_OverrideStones = (totalInfluence/getAmountOfCells()) * 200;
+	overrideStoneWeight = (totalInfluence/cellcount) * 200;
 
 	int totalNeigbours=0;
-	for(uint16_t cell=0; cell<getAmountOfCells(); ++cell)
+	for(uint16_t cell=0; cell<cellcount; ++cell)
 	{
 		for(int d=0; d<DIRECTION_COUNT; ++d)
 		{
@@ -701,66 +917,452 @@ Map::Map(istream& is)
 		}
 	}
 
-	WEIGHT_Bombs = (int)(pow(((double)totalNeigbours/getAmountOfCells()), bombExplosionRadius) * 200);
-
-	adaptStableState();
+	bombWeight = (int)(pow(((double)totalNeigbours/cellcount), bombExplosionRadius) * 200);
 }
 
 /**
- * Create an empty map. All the array are initialized to the correct sizes for the current game. 
- * Copying a specific state into them has to be done with the Map::copy() method.
+ * Frees all memory allocated for the static part of the board.
  */
-Map::Map()
+MapTopology::~MapTopology()
 {
-	amountOfInversionStones=0;
-	amountOfChoiceStones=0;
-	board = new char[getAmountOfCells()];
-	amountOfFreeCellsOnLine = new uint16_t[lineCount];
-	isStoneStable = new bool[getAmountOfCells()*LINE_COUNT];
+	delete[] startBoard;
+	delete[] existentCell;
+	delete[] cellsOnLine;
+	delete[] rayCells;
+	delete[] rayBegin;
+	delete[] transitionCells;
+	delete[] linkingCells;
+	delete[] linkingBegin;
+	delete[] rayPrefix;
+	delete[] zobristKeys;
+
+	for(int orientation=0; orientation<LINE_COUNT; ++orientation)
+	{
+		delete[] cellToBit[orientation];
+		delete[] bitToCell[orientation];
+	}
+
+	for(int dir=0; dir<DIRECTION_COUNT; ++dir)
+	{
+		delete[] lineContinuation[dir];
+	}
 }
 
 /**
- * Destructor for a map instance. Free all the memory that is needed for
- * an instance of map, which stores the dynamic parts of a map.
+ * Add a new neighbour to the data structure
+ *
+ * @param x1   - The x coordinate of the first cell to be linked
+ * @param y1   - The y coordinate of the first cell to be linked
+ * @param dir1 - The direction of the link from the perspective of the first cell
+ * @param x2   - The x coordinate of the second cell to be linked
+ * @param y2   - The y coordinate of the first second to be linked
+ * @param dir2 - The direction of the link from the perspective of the second cell
  */
-Map::~Map()
+void MapTopology::addNeighbour(uint16_t x1, uint16_t y1, uint8_t dir1, uint16_t x2, uint16_t y2, uint8_t dir2)
 {
-	delete [] board;
-	delete [] amountOfFreeCellsOnLine;
-	delete [] isStoneStable;
+	uint16_t cell1 = offsetMap[x1][y1];
+	uint16_t cell2 = offsetMap[x2][y2];
+	(existentCell[cell1]).neighbour[dir1] = cell2;
+	(existentCell[cell1]).direction[dir1] = (dir2+4) % DIRECTION_COUNT;
+	(existentCell[cell2]).neighbour[dir2] = cell1;
+	(existentCell[cell2]).direction[dir2] = (dir1+4) % DIRECTION_COUNT;
 }
 
 /**
- * Copies the state of the map passed as argument to this instance of Map.
+ * Counts the set bits of a bitboard.
  *
- * @param toCopy - The map that shall be copied
+ * @param bits - The bitboard
+ * @return The amount of set bits
  */
-void Map::copy(Map& toCopy)
+inline int MapTopology::countBits(const uint64_t* bits) const
 {
-	memcpy(board, toCopy.board, getAmountOfCells()*sizeof(char));
+	int count=0;
+	for(int w=0; w<bitboardWordCount; ++w)
+	{
+		count+=__builtin_popcountll(bits[w]);
+	}
+	return count;
+}
 
-	memcpy(overrideStones, toCopy.overrideStones, sizeof(uint16_t)*(MAX_PLAYER+1));
-	memcpy(numberOfBombs, toCopy.numberOfBombs, sizeof(uint16_t)*(MAX_PLAYER+1));
-	memcpy(playerMap, toCopy.playerMap, MAX_PLAYER+1);
+/**
+ * Moves every set bit of a rotated bitboard by one cell into the specified direction.
+ * Bits that would leave their line are dropped. Only the words from first to last are written,
+ * so the bits of the input have to lie within them after being moved.
+ *
+ * @param in    - The bitboard that should be shifted
+ * @param out   - The bitboard the result is written to
+ * @param dir   - The direction into which the bits are moved
+ * @param first - The first word of the output that is written
+ * @param last  - The last word of the output that is written
+ */
+inline void MapTopology::shiftBitboard(const uint64_t* in, uint64_t* out, uint8_t dir, int first, int last) const
+{
+	const uint64_t* mask = lineContinuation[dir];
 
-	amountOfInversionStones = toCopy.amountOfInversionStones;
-	amountOfChoiceStones = toCopy.amountOfChoiceStones;
+	if(isForwardDirection(dir))
+	{
+		for(int w=first; w<=last; ++w)
+		{
+			uint64_t carry = w>0 ? in[w-1]>>63 : 0;
+			out[w] = ((in[w]<<1)|carry) & mask[w];
+		}
+	}
+	else
+	{
+		for(int w=first; w<=last; ++w)
+		{
+			uint64_t carry = w+1<bitboardWordCount ? in[w+1]<<63 : 0;
+			out[w] = ((in[w]>>1)|carry) & mask[w];
+		}
+	}
+}
 
-	memcpy(amountOfFreeCellsOnLine, toCopy.amountOfFreeCellsOnLine, lineCount*sizeof(uint16_t));
+/**
+ * Checks whether the step from a cell into a direction follows the regular grid,
+ * so that neither the direction changes nor a transition gets used.
+ * The step back has to be regular as well, otherwise a transition replaced one side of the link.
+ *
+ * @param cell - The cell from which the step is made
+ * @param dir  - The direction of the step
+ * @return True if the neighbour in that direction is the geometric neighbour, false otherwise
+ */
+bool MapTopology::isTrivialStep(uint16_t cell, uint8_t dir) const
+{
+	uint16_t neighbour = existentCell[cell].neighbour[dir];
 
-	memcpy(isStoneStable, toCopy.isStoneStable, getAmountOfCells()*sizeof(bool)*4);
+	return (neighbour != NO_CELL) && (existentCell[cell].direction[dir] == dir)
+		&& (reverseOffsetX[neighbour] == reverseOffsetX[cell]+directionX[dir])
+		&& (reverseOffsetY[neighbour] == reverseOffsetY[cell]+directionY[dir])
+		&& (existentCell[neighbour].neighbour[(dir+4)%DIRECTION_COUNT] == cell)
+		&& (existentCell[neighbour].direction[(dir+4)%DIRECTION_COUNT] == (dir+4)%DIRECTION_COUNT);
 }
 
+#ifdef RAY_GATHER
 /**
- * Draw the map to the standard output stream.
+ * Vectorized version of Map::hasCaptures. Loads the states of one step into all 8 directions at once
+ * with an AVX2 gather and compares them to the own colour and the states that end a ray.
+ * Rays whose first RAY_PREFIX_LENGTH cells can all be captured are followed one by one afterwards.
+ *
+ * @param board  - The board of the map, including the padding behind the cells
+ * @param start  - The offset of the cell where a stone should be placed on
+ * @param colour - The colour of the stones of the player that is moving
+ * @return	True if at least one stone would be captured, false if not
  */
-void Map::draw()
+__attribute__((target("avx2")))
+bool MapTopology::hasCapturesGathered(const char* board, uint16_t start, char colour) const
 {
-	for(int y=0; y<getHeight(); ++y)
+	const int32_t* prefix = rayPrefix + start*RAY_PREFIX_LENGTH*DIRECTION_COUNT;
+	const __m256i byteMask = _mm256_set1_epi32(0xFF);
+	const __m256i own = _mm256_set1_epi32(colour);
+	const __m256i empty = _mm256_setzero_si256();
+	const __m256i choice = _mm256_set1_epi32('c');
+	const __m256i bonus = _mm256_set1_epi32('b');
+	const __m256i inversion = _mm256_set1_epi32('i');
+
+	// Lanes of the directions whose rays have only passed capturable stones so far
+	__m256i open = _mm256_set1_epi32(-1);
+
+	for(int step=0; step<RAY_PREFIX_LENGTH; ++step)
 	{
-		for(int x=0; x<getWidth(); ++x)
+		__m256i index = _mm256_loadu_si256((const __m256i*)(prefix + step*DIRECTION_COUNT));
+		__m256i state = _mm256_and_si256(_mm256_i32gather_epi32((const int*)board, index, 1), byteMask);
+
+		__m256i isOwn = _mm256_cmpeq_epi32(state, own);
+		if(step>0 && !_mm256_testz_si256(isOwn, open))
 		{
-			int index = getOffset(x, y);
+			return true;
+		}
+
+		__m256i isEnd = _mm256_or_si256(_mm256_or_si256(isOwn, _mm256_cmpeq_epi32(state, empty)),
+			_mm256_or_si256(_mm256_cmpeq_epi32(state, choice), _mm256_or_si256(_mm256_cmpeq_epi32(state, bonus), _mm256_cmpeq_epi32(state, inversion))));
+		open = _mm256_andnot_si256(isEnd, open);
+
+		if(_mm256_testz_si256(open, open))
+		{
+			return false;
+		}
+	}
+
+	int openDirections = _mm256_movemask_ps(_mm256_castsi256_ps(open));
+	while(openDirections)
+	{
+		int dir = __builtin_ctz(openDirections);
+		openDirections &= openDirections-1;
+
+		const uint16_t* cur = rayCells + rayBegin[DIRECTION_COUNT*start+dir] + RAY_PREFIX_LENGTH;
+		const uint16_t* last = rayCells + rayBegin[DIRECTION_COUNT*start+dir+1];
+
+		while(cur != last && !isRayEnd(board[*cur], colour))
+		{
+			++cur;
+		}
+
+		if(cur != last && board[*cur] == colour)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+#endif
+
+////////////////////////////////////////
+////			     				////
+////  PUBLIC METHODES OF MAP CLASS  ////
+////                    			////
+////////////////////////////////////////
+
+/**
+ * Constructor for a map instance for reading a map from a text file or the server. 
+ * This should always be used for the initial construction of a map. 
+ * The default constructor should only be used if another map will
+ * be copied into it via the copy() function.
+ *
+ * @param is - A reference to a byte stream which contains the information of a map
+ */
+Map::Map(istream& is) : Map(make_shared<MapTopology>(is))
+{
+}
+
+/**
+ * Constructor for a map instance in the start position of an already parsed map.
+ * Several games can be played on one topology, e.g. by passing getTopology() of another map.
+ *
+ * @param topology - The static part of the map
+ */
+Map::Map(shared_ptr<const MapTopology> topology) : topology(topology)
+{
+	allocateState();
+
+	// Initialize the override stone and bomb count for every player.
+	// At the same time initialize the player map and the disqualification array
+	disqualified[0] = true;
+	playerMap[0] = 0;	// Zero will always map to itself
+
+	for(int p=1; p<=MAX_PLAYER; ++p)
+	{
+		if(p <= getAmountOfPlayers())
+		{
+			overrideStones[p] = topology->startOverrideStones;
+			numberOfBombs[p] = topology->startBombs;
+			playerMap[p] = p;
+			disqualified[p] = false;
+			nextPlayers[p-1] = p;
+		}
+		else
+		{
+			overrideStones[p] = 0;
+			numberOfBombs[p] = 0;
+			playerMap[p] = NO_PLAYER; // Mark player as 'not a player'
+			disqualified[p] = true;
+		}
+	}
+	amountOfActivePlayers = getAmountOfPlayers();
+
+	// Every player is considered until initializeNeighbourList() is called
+	amountOfConsideredPlayers = getAmountOfPlayers();
+	updateTurnOrderKey();
+
+	amountOfInversionStones=0;
+	amountOfChoiceStones=0;
+	isRecording=false;
+
+	memcpy(board, topology->startBoard, getAmountOfCells()*sizeof(char));
+	memset(board+getAmountOfCells(), 0, BOARD_PADDING);
+
+	// Count the cells on every line that can still be played
+	memset(amountOfFreeCellsOnLine, 0, topology->lineCount*sizeof(uint16_t));
+	for(int line=0; line<topology->lineCount; ++line)
+	{
+		for(vector<int>::const_iterator it=topology->cellsOnLine[line].begin(); it!=topology->cellsOnLine[line].end(); ++it)
+		{
+			if(board[*it]<1 || (board[*it]>MAX_PLAYER && board[*it]!='x') )
+			{
+				amountOfFreeCellsOnLine[line]++;
+			}
+		}
+	}
+
+	memset(bitboard, 0, (LINE_COUNT*(getAmountOfPlayers()+1)+COMPACTED_SLOT_COUNT)*topology->bitboardWordCount*sizeof(uint64_t));
+
+	for(int cell=0; cell<getAmountOfCells(); ++cell)
+	{
+		updateBitboards(cell, board[cell], true);
+	}
+
+	// Count the stones next to every cell and collect the cells on which a move might be possible
+	memset(stoneNeighbours, 0, getAmountOfCells()*sizeof(uint8_t));
+
+	for(int cell=0; cell<getAmountOfCells(); ++cell)
+	{
+		for(int dir=0; dir<DIRECTION_COUNT; ++dir)
+		{
+			if(topology->existentCell[cell].neighbour[dir]!=NO_CELL && isStone(board[topology->existentCell[cell].neighbour[dir]]))
+			{
+				stoneNeighbours[cell]++;
+			}
+		}
+	}
+	for(int cell=0; cell<getAmountOfCells(); ++cell)
+	{
+		updateCandidateState(cell);
+	}
+
+	// No stone is rated yet, the first evaluation rates all of them
+	memset(colourRating, 0, sizeof(colourRating));
+	memset(cellRating, 0, getAmountOfCells()*sizeof(int));
+	memset(cellRatingColour, 0, getAmountOfCells()*sizeof(uint8_t));
+	memset(isCellRatingOutdated, 0, getAmountOfCells()*sizeof(bool));
+	for(int cell=0; cell<getAmountOfCells(); ++cell)
+	{
+		markCellRatingOutdated(cell);
+	}
+
+	// Mark the stones that are stable on a line, as it ends at a hole or is already full
+	memset(isStoneStable, 0, 2*LINE_COUNT*getAmountOfCells()*sizeof(bool));
+	memset(stableLineCount, 0, 2*getAmountOfCells()*sizeof(uint8_t));
+
+	for(int cell=0; cell<getAmountOfCells(); ++cell)
+	{
+		for(int dir=0; dir<LINE_COUNT; ++dir)
+		{
+			isStoneStable[LINE_COUNT*cell+dir] = isBaseStable(cell, dir);
+			stableLineCount[cell] += isStoneStable[LINE_COUNT*cell+dir];
+		}
+	}
+
+	//Set the amount of likely reachable inversion and choice stones
+	for(uint16_t cell=0; cell<getAmountOfCells(); ++cell)
+	{
+		if(getState(cell)=='i')
+		{
+			if(isStoneReachable(cell))
+			{
+				amountOfInversionStones++;
+			}
+		}
+		else if(getState(cell)=='c')
+		{
+			if(isStoneReachable(cell))
+			{
+				amountOfChoiceStones++;
+			}
+		}
+	}
+
+	cout << "Amount of reachable inversion stones: "<< amountOfInversionStones<<endl;
+	cout << "Amount of reachable choice stones: "<< amountOfChoiceStones<<endl;
+
+	adaptStableState();
+
+	// A reset would give the same flags, as there are no moves yet
+	memcpy(isStoneStable+LINE_COUNT*getAmountOfCells(), isStoneStable, LINE_COUNT*getAmountOfCells()*sizeof(bool));
+	memcpy(stableLineCount+getAmountOfCells(), stableLineCount, getAmountOfCells()*sizeof(uint8_t));
+	stabilityDifferences.clear();
+
+	hashKey = getPlayerMapKey();
+	for(uint16_t cell=0; cell<getAmountOfCells(); ++cell)
+	{
+		hashKey ^= topology->zobristKeys[cell*ZOBRIST_STATE_COUNT + topology->zobristState[(uint8_t)board[cell]]];
+	}
+	for(uint8_t p=1; p<=getAmountOfPlayers(); ++p)
+	{
+		hashKey ^= getStoneCountKey(p);
+	}
+}
+
+/**
+ * Create an empty map. Copying a specific state into it has to be done with the Map::copy() method,
+ * which also allocates the arrays for the topology of the copied map.
+ */
+Map::Map()
+{
+	amountOfInversionStones=0;
+	amountOfChoiceStones=0;
+	isRecording=false;
+	hashKey=0;
+	allocateState();
+}
+
+/**
+ * Destructor for a map instance. Free all the memory that is needed for
+ * an instance of map, which stores the dynamic parts of a map.
+ * The topology is freed together with the last map that uses it.
+ */
+Map::~Map()
+{
+	releaseState();
+}
+
+/**
+ * Copies the state of the map passed as argument to this instance of Map.
+ * If the map belongs to another topology, this map switches to that topology.
+ *
+ * @param toCopy - The map that shall be copied
+ */
+void Map::copy(Map& toCopy)
+{
+	if(topology != toCopy.topology)
+	{
+		releaseState();
+		topology = toCopy.topology;
+		allocateState();
+	}
+
+	memcpy(board, toCopy.board, getAmountOfCells()*sizeof(char));
+
+	memcpy(overrideStones, toCopy.overrideStones, sizeof(uint16_t)*(MAX_PLAYER+1));
+	memcpy(numberOfBombs, toCopy.numberOfBombs, sizeof(uint16_t)*(MAX_PLAYER+1));
+	memcpy(playerMap, toCopy.playerMap, MAX_PLAYER+1);
+
+	memcpy(disqualified, toCopy.disqualified, sizeof(disqualified));
+	amountOfActivePlayers = toCopy.amountOfActivePlayers;
+	memcpy(nextPlayers, toCopy.nextPlayers, sizeof(nextPlayers));
+	amountOfConsideredPlayers = toCopy.amountOfConsideredPlayers;
+	turnOrderKey = toCopy.turnOrderKey;
+
+	amountOfInversionStones = toCopy.amountOfInversionStones;
+	amountOfChoiceStones = toCopy.amountOfChoiceStones;
+	hashKey = toCopy.hashKey;
+
+	memcpy(amountOfFreeCellsOnLine, toCopy.amountOfFreeCellsOnLine, topology->lineCount*sizeof(uint16_t));
+
+	memcpy(isStoneStable, toCopy.isStoneStable, 2*LINE_COUNT*getAmountOfCells()*sizeof(bool));
+	memcpy(stableLineCount, toCopy.stableLineCount, 2*getAmountOfCells()*sizeof(uint8_t));
+	stabilityDifferences = toCopy.stabilityDifferences;
+
+	memcpy(colourRating, toCopy.colourRating, sizeof(colourRating));
+	memcpy(cellRating, toCopy.cellRating, getAmountOfCells()*sizeof(int));
+	memcpy(cellRatingColour, toCopy.cellRatingColour, getAmountOfCells()*sizeof(uint8_t));
+	memcpy(isCellRatingOutdated, toCopy.isCellRatingOutdated, getAmountOfCells()*sizeof(bool));
+	outdatedCellRatings = toCopy.outdatedCellRatings;
+
+	memcpy(bitboard, toCopy.bitboard, (LINE_COUNT*(getAmountOfPlayers()+1)+COMPACTED_SLOT_COUNT)*topology->bitboardWordCount*sizeof(uint64_t));
+	memcpy(stoneNeighbours, toCopy.stoneNeighbours, getAmountOfCells()*sizeof(uint8_t));
+}
+
+/**
+ * Getter function for the static part of the map, which can be used to start another game on the same map.
+ *
+ * @return The topology shared by this map and its copies
+ */
+shared_ptr<const MapTopology> Map::getTopology()
+{
+	return topology;
+}
+
+
+/**
+ * Draw the map to the standard output stream.
+ */
+void Map::draw()
+{
+	for(int y=0; y<getHeight(); ++y)
+	{
+		for(int x=0; x<getWidth(); ++x)
+		{
+			int index = getOffset(x, y);
 
 			if(index == NO_CELL || board[index]==NO_STONE)
 			{
@@ -833,7 +1435,7 @@ void Map::initializeNeighbourList(uint8_t player)
 					// Look at every neighbour
 					for(int dir=0; dir<DIRECTION_COUNT; ++dir)
 					{
-						int neighbour=existentCell[cell].neighbour[dir];
+						int neighbour=topology->existentCell[cell].neighbour[dir];
 						// If the neighbour is joining stone, add it to the list
 						if((neighbour!=NO_CELL) && neighbouringCells.find(neighbour)==neighbouringCells.end())
 						{
@@ -847,7 +1449,7 @@ void Map::initializeNeighbourList(uint8_t player)
 					// Look at every neighbour
 					for(int dir=0; dir<DIRECTION_COUNT; ++dir)
 					{
-						int neighbour=existentCell[cell].neighbour[dir];
+						int neighbour=topology->existentCell[cell].neighbour[dir];
 						// Add it only if it is a player or expansion stone
 						if((neighbour!=NO_CELL) && (neighbouringCells.find(neighbour)==neighbouringCells.end())
 								&& (getState(neighbour)=='x' || (getState(neighbour)!=0 && getState(neighbour)<=MAX_PLAYER)))
@@ -870,14 +1472,14 @@ void Map::initializeNeighbourList(uint8_t player)
 		}
 	}
 
-	nextPlayers.clear();
-	nextPlayers.push_back(player);
+	amountOfConsideredPlayers=0;
+	nextPlayers[amountOfConsideredPlayers++] = player;
 
 	for(set<uint8_t>::iterator it=neighbouringPlayers.begin(); it!=neighbouringPlayers.end(); ++it)
 	{
 		if(*it>player)
 		{
-			nextPlayers.push_back(*it);
+			nextPlayers[amountOfConsideredPlayers++] = *it;
 		}
 	}
 
@@ -885,7 +1487,102 @@ void Map::initializeNeighbourList(uint8_t player)
 	{
 		if(*it<player)
 		{
-			nextPlayers.push_back(*it);
+			nextPlayers[amountOfConsideredPlayers++] = *it;
+		}
+	}
+
+	updateTurnOrderKey();
+}
+
+/**
+ * Measures how closely every other player interacts with the given one. The distance is found by a breadth first
+ * search from the stones of the player, which walks over all cells and transitions. A shared line is a line on
+ * which both players have a stone and which has a free cell left, so that one of them can still capture there.
+ *
+ * @param player - The player whose opponents are measured
+ * @param interactions - Gets the interaction of every player, indexed by the player, the one of the player itself is left out
+ */
+void Map::getInteractions(uint8_t player, Interaction* interactions)
+{
+	for(uint8_t p=1; p<=getAmountOfPlayers(); ++p)
+	{
+		interactions[p].distance = INT_MAX;
+		interactions[p].sharedLines = 0;
+		interactions[p].contacts = 0;
+	}
+
+	vector<int> distance(getAmountOfCells(), INT_MAX);
+	queue<uint16_t> cells;
+	for(uint16_t cell=0; cell<getAmountOfCells(); ++cell)
+	{
+		if(getPlayerStoneOwnership(getState(cell))==player)
+		{
+			distance[cell]=0;
+			cells.push(cell);
+		}
+	}
+
+	while(!cells.empty())
+	{
+		uint16_t cell=cells.front();
+		cells.pop();
+
+		bool hasTouched[MAX_PLAYER+1] = {false};
+		for(int dir=0; dir<DIRECTION_COUNT; ++dir)
+		{
+			uint16_t neighbour=topology->existentCell[cell].neighbour[dir];
+			if(neighbour==NO_CELL)
+			{
+				continue;
+			}
+
+			uint8_t owner=getPlayerStoneOwnership(getState(neighbour));
+			if(owner!=NO_PLAYER && owner!=0 && owner!=player)
+			{
+				interactions[owner].distance = min(interactions[owner].distance, distance[cell]+1);
+
+				// Count every stone of the player once per opponent it touches
+				if(distance[cell]==0 && !hasTouched[owner])
+				{
+					hasTouched[owner]=true;
+					interactions[owner].contacts++;
+				}
+			}
+
+			if(distance[neighbour]==INT_MAX)
+			{
+				distance[neighbour]=distance[cell]+1;
+				cells.push(neighbour);
+			}
+		}
+	}
+
+	for(int line=0; line<topology->lineCount; ++line)
+	{
+		if(amountOfFreeCellsOnLine[line]==0)
+		{
+			continue;
+		}
+
+		bool isOnLine[MAX_PLAYER+1] = {false};
+		for(vector<int>::const_iterator it=topology->cellsOnLine[line].begin(); it!=topology->cellsOnLine[line].end(); ++it)
+		{
+			uint8_t owner=getPlayerStoneOwnership(getState(*it));
+			if(owner!=NO_PLAYER)
+			{
+				isOnLine[owner]=true;
+			}
+		}
+
+		if(isOnLine[player])
+		{
+			for(uint8_t p=1; p<=getAmountOfPlayers(); ++p)
+			{
+				if(p!=player && isOnLine[p])
+				{
+					interactions[p].sharedLines++;
+				}
+			}
 		}
 	}
 }
@@ -904,6 +1601,24 @@ void Map::initializeNeighbourList(uint8_t player)
  * @return	True if the move was valid and could be executed, false otherwise
  */
 bool Map::isPlayingPhaseMoveValid(uint16_t start, uint8_t player, uint8_t choice)
+{
+	uint16_t captures[getMaximumCaptureCount()];
+
+	return isPlayingPhaseMoveValid(start, player, choice, captures);
+}
+
+/**
+ * Tries placing a stone at the cell at coordinates (x,y) for the given player.
+ * Works like isPlayingPhaseMoveValid(start, player, choice), but collects the recoloured
+ * cells in a buffer of the caller, so that no memory has to be allocated during the move search.
+ *
+ * @param start    - The index of the Cell on which a stone should be played
+ * @param player   - The player who makes the move
+ * @param choice   - Contains information for choice or bonus stones (see above)
+ * @param captures - A buffer with space for at least getMaximumCaptureCount() cells
+ * @return	True if the move was valid and could be executed, false otherwise
+ */
+bool Map::isPlayingPhaseMoveValid(uint16_t start, uint8_t player, uint8_t choice, uint16_t* captures)
 {
 	// Check if cell exists
 	if(start == NO_CELL)
@@ -920,47 +1635,53 @@ bool Map::isPlayingPhaseMoveValid(uint16_t start, uint8_t player, uint8_t choice
 	}
 
 	// Get the cells that are to be recoloured by the move
-	vector<int> recolourList = getMoveCaptures(start, player);
+	int captureCount = getMoveCaptures(start, player, captures);
 
 	uint8_t curPlayer = playerMap[player];
 
 	// If there are stones that get turned, the move is valid and it can be executed
-	if(recolourList.size()>0)
+	if(captureCount>0)
 	{
+		bool isResettingStableState = false;
+
 		if(state=='c')
 		{
-			amountOfChoiceStones--;
 			if((choice==0) || (choice>getAmountOfPlayers()))
 			{
 				return false;
 			}
+			amountOfChoiceStones--;
+			hashKey ^= getPlayerMapKey();
 			int helper = playerMap[player];
 			playerMap[player] = playerMap[choice];
 			playerMap[choice] = helper;
-			resetStableState();
+			hashKey ^= getPlayerMapKey();
+			isResettingStableState = true;
 		}
 		else if(state=='b')
 		{
 			if(choice == 20)
 			{	// 20 represents the choice for a bomb
-				numberOfBombs[player]++;
+				changeStoneCounts(player, 0, 1);
 			}
 			else if(choice == 21)
 			{	// 21 represents the choice for an override stone
-				overrideStones[player]++;
+				changeStoneCounts(player, 1, 0);
 			}
 		}
 		else if(state=='i')
 		{
 			amountOfInversionStones--;
 			// Switch each player with his corresponding target
+			hashKey ^= getPlayerMapKey();
 			int temp = playerMap[getAmountOfPlayers()];
 			for(int i=getAmountOfPlayers(); i>0; i--)
 			{
 				playerMap[i]=playerMap[i-1];
 			}
 			playerMap[1]=temp;
-			resetStableState();
+			hashKey ^= getPlayerMapKey();
+			isResettingStableState = true;
 		}
 		else if(state==0)
 		{
@@ -968,27 +1689,36 @@ bool Map::isPlayingPhaseMoveValid(uint16_t start, uint8_t player, uint8_t choice
 		}
 		else
 		{
-			overrideStones[player]--;
-			resetStableState();
+			changeStoneCounts(player, -1, 0);
+			isResettingStableState = true;
 		}
 
+		invalidateStableState(start, captures, captureCount);
+
 		if(state==0 || (state>MAX_PLAYER && state!='x'))
 		{
 			int previous[4]={-1,-1,-1,-1};
 
 			for(int dir=0; dir<LINE_COUNT; ++dir)
 			{
-				int line=existentCell[start].lineIndex[dir];
+				int line=topology->existentCell[start].lineIndex[dir];
 
-				if(line!=previous[0] && line!=previous[1] && line!=previous[2] &&(--amountOfFreeCellsOnLine[line])==0)
+				if(line!=previous[0] && line!=previous[1] && line!=previous[2])
 				{
-					for (vector<int>::iterator it = cellsOnLine[line].begin(); it != cellsOnLine[line].end(); ++it)
+					setFreeCellsOnLine(line, amountOfFreeCellsOnLine[line]-1);
+
+					if(amountOfFreeCellsOnLine[line]==0)
 					{
-						for(int i=0; i<LINE_COUNT; ++i)
+						for (vector<int>::iterator it = topology->cellsOnLine[line].begin(); it != topology->cellsOnLine[line].end(); ++it)
 						{
-							if(existentCell[*it].lineIndex[i]==line)
+							for(int i=0; i<LINE_COUNT; ++i)
 							{
-								isStoneStable[4*(*it)+i]=true;
+								if(topology->existentCell[*it].lineIndex[i]==line)
+								{
+									setStoneStable(LINE_COUNT*getAmountOfCells() + LINE_COUNT*(*it)+i, true);
+									setStoneStable(LINE_COUNT*(*it)+i, true);
+									stabilityChangedCells.push_back(*it);
+								}
 							}
 						}
 					}
@@ -997,24 +1727,30 @@ bool Map::isPlayingPhaseMoveValid(uint16_t start, uint8_t player, uint8_t choice
 			}
 		}
 
-		board[start] = curPlayer;
+		setState(start, curPlayer);
 
-		// Recolour all the cells in the recolouring list, draw map and return success
-		for(unsigned int i=0; i<recolourList.size(); ++i)
+		// Recolour all the captured cells, draw map and return success
+		for(int i=0; i<captureCount; ++i)
 		{
-			board[recolourList[i]] = curPlayer;
+			setState(captures[i], curPlayer);
 		}
 
-		adaptStableState();
+		updateStableState(start, captures, captureCount);
+
+		if(isResettingStableState)
+		{
+			resetStableState();
+		}
 
 		return true;
 	}
 	else if(board[start] == 'x') // Expansion rule
 	{	// Recolour the starting cell, draw the new map and return success
-		board[start] = curPlayer;
-		overrideStones[player]--;
+		invalidateStableState(start, captures, 0);
+		setState(start, curPlayer);
+		changeStoneCounts(player, -1, 0);
 
-		adaptStableState();
+		updateStableState(start, captures, 0);
 
 		return true;
 	}
@@ -1040,22 +1776,128 @@ bool Map::isBombingPhaseMoveValid(uint16_t start, uint8_t player, uint8_t choice
 	}
 
 	// Delete the cells that get hit by the bomb
-	bombCell(start, bombExplosionRadius);
+	uint8_t hit[getAmountOfCells()];
+	memset(hit, 0, getAmountOfCells()*sizeof(uint8_t));
+
+	bombCell(start, topology->bombExplosionRadius, hit);
 	for(int cell=0; cell<getAmountOfCells(); ++cell)
 	{
-		if(board[cell] >= (NO_STONE-bombExplosionRadius))
+		if(hit[cell])
 		{
-			board[cell]=NO_STONE;
+			setState(cell, NO_STONE);
 		}
 	}
-	numberOfBombs[player]--;
+	changeStoneCounts(player, 0, -1);
 
 	return true;
 }
 
+/**
+ * Executes a move like isPlayingPhaseMoveValid() or isBombingPhaseMoveValid(), but records
+ * everything the move changes, so that it can be taken back with unmakeMove().
+ * This allows the search to work on one map instead of copying the map for every move.
+ * Moves have to be taken back in the reverse order in which they were made.
+ *
+ * @param start          - The index of the cell on which the move is made
+ * @param player         - The player who makes the move
+ * @param choice         - Contains information for choice or bonus stones (see isPlayingPhaseMoveValid())
+ * @param isPlayingPhase - True if the move is made in the playing phase, false for the bombing phase
+ * @param captures       - A buffer with space for at least getMaximumCaptureCount() cells
+ * @param undo           - The record which is filled with the information to take back the move
+ * @return	True if the move was valid and was executed, false otherwise (the map is unchanged then)
+ */
+bool Map::makeMove(uint16_t start, uint8_t player, uint8_t choice, bool isPlayingPhase, uint16_t* captures, UndoRecord& undo)
+{
+	undo.hashKey = hashKey;
+	undo.cellJournalSize = cellJournal.size();
+	undo.stabilityJournalSize = stabilityJournal.size();
+	undo.lineJournalSize = lineJournal.size();
+	undo.stabilityDifferenceCount = stabilityDifferences.size();
+	undo.overrideStones = overrideStones[player];
+	undo.numberOfBombs = numberOfBombs[player];
+	undo.amountOfInversionStones = amountOfInversionStones;
+	undo.amountOfChoiceStones = amountOfChoiceStones;
+	memcpy(undo.playerMap, playerMap, MAX_PLAYER+1);
+	undo.player = player;
+
+	isRecording = true;
+	bool isValid;
+	if(isPlayingPhase)
+	{
+		isValid = isPlayingPhaseMoveValid(start, player, choice, captures);
+	}
+	else
+	{
+		isValid = isBombingPhaseMoveValid(start, player, choice);
+	}
+	isRecording = false;
+
+	return isValid;
+}
+
+/**
+ * Takes back the last move that was made with makeMove() and not yet taken back.
+ *
+ * @param undo - The record that was filled by makeMove()
+ */
+void Map::unmakeMove(UndoRecord& undo)
+{
+	while(cellJournal.size()>undo.cellJournalSize)
+	{
+		// Restore without recording and in reverse order, as a cell may have changed more than once
+		writeState(cellJournal.back().first, cellJournal.back().second);
+		cellJournal.pop_back();
+	}
+
+	rewindStabilityJournals(undo.stabilityJournalSize, undo.lineJournalSize);
+
+	if(stabilityDifferences.size()>undo.stabilityDifferenceCount)
+	{
+		stabilityDifferences.resize(undo.stabilityDifferenceCount);
+	}
+
+	overrideStones[undo.player] = undo.overrideStones;
+	numberOfBombs[undo.player] = undo.numberOfBombs;
+	amountOfInversionStones = undo.amountOfInversionStones;
+	amountOfChoiceStones = undo.amountOfChoiceStones;
+	memcpy(playerMap, undo.playerMap, MAX_PLAYER+1);
+	hashKey = undo.hashKey;
+}
+
+/**
+ * Takes back the recorded changes of the stability flags and line counters,
+ * until the journals are shrunk to the given sizes.
+ *
+ * @param stabilityJournalSize - The size of the stability journal to return to
+ * @param lineJournalSize      - The size of the line journal to return to
+ */
+void Map::rewindStabilityJournals(uint32_t stabilityJournalSize, uint32_t lineJournalSize)
+{
+	while(stabilityJournal.size()>stabilityJournalSize)
+	{
+		uint32_t index = stabilityJournal.back();
+		isStoneStable[index] = !isStoneStable[index];
+		stableLineCount[index/LINE_COUNT] += isStoneStable[index] ? 1 : -1;
+		if(index<LINE_COUNT*getAmountOfCells())
+		{
+			markCellRatingOutdated(index/LINE_COUNT);
+		}
+		stabilityJournal.pop_back();
+	}
+
+	while(lineJournal.size()>lineJournalSize)
+	{
+		amountOfFreeCellsOnLine[lineJournal.back().first] = lineJournal.back().second;
+		lineJournal.pop_back();
+	}
+}
+
 /**
  * Associate a score to the current board state from the perspective of the specified player. 
  * The heuristic generates a higher score the more promising a position looks.
+ * Only the stones that changed since the last evaluation are rated again, the ratings of the other
+ * stones are taken from the sums of their colours. Compiling with CHECK_EVALUATION compares the
+ * result to evaluateForPlayingPhaseFromScratch().
  *
  * @param player - The player from whose perspective the board is evaluated
  * @return	The generated score
@@ -1068,8 +1910,68 @@ int64_t Map::evaluateForPlayingPhase(uint8_t player)
 
 	for(int p=0; p<getAmountOfPlayers();p++)
 	{
-		rating[p]=overrideStones[p+1]*WEIGHT_OverrideStones;
-		rating[p]+=numberOfBombs[p+1]*WEIGHT_Bombs;
+		rating[p]=overrideStones[p+1]*topology->overrideStoneWeight;
+		rating[p]+=numberOfBombs[p+1]*topology->bombWeight;
+	}
+
+	updateCellRatings();
+
+	for(int colour=1; colour<=getAmountOfPlayers(); ++colour)
+	{
+		rating[(getPlayerStoneOwnership(colour)+expectedPlayerOffset-1)%getAmountOfPlayers()]+=colourRating[colour];
+	}
+
+	int64_t ourRating = rating[(player+expectedPlayerOffset-1)%getAmountOfPlayers()];
+
+	int betterPlayers=0;
+	int64_t total=0;
+	for(int p=0; p<getAmountOfPlayers();p++)
+	{
+		if(p != (player+expectedPlayerOffset-1)%getAmountOfPlayers())
+		{
+			total+=rating[p];
+			if(rating[p]>ourRating)
+			{
+				betterPlayers++;
+			}
+		}
+	}
+
+	if(amountOfChoiceStones>0)
+	{
+		if(betterPlayers==0)
+			betterPlayers=(getAmountOfPlayers()/2);
+	}
+
+	int64_t score = (getAmountOfPlayers()*ourRating-total)-betterPlayers*10000000;
+
+#ifdef CHECK_EVALUATION
+	if(score != evaluateForPlayingPhaseFromScratch(player))
+	{
+		cerr << "The evaluation of player " << (int)player << " differs from the one from scratch: " << score << " instead of " << evaluateForPlayingPhaseFromScratch(player) << endl;
+	}
+#endif
+
+	return score;
+}
+
+/**
+ * Computes the same score as evaluateForPlayingPhase(), but rates every stone on the board again.
+ * Used to check the ratings that are kept between the evaluations.
+ *
+ * @param player - The player from whose perspective the board is evaluated
+ * @return	The generated score
+ */
+int64_t Map::evaluateForPlayingPhaseFromScratch(uint8_t player)
+{
+	uint8_t expectedPlayerOffset = getAmountOfInversionStones();
+
+	int64_t rating[getAmountOfPlayers()];
+
+	for(int p=0; p<getAmountOfPlayers();p++)
+	{
+		rating[p]=overrideStones[p+1]*topology->overrideStoneWeight;
+		rating[p]+=numberOfBombs[p+1]*topology->bombWeight;
 	}
 
 	//TODO implement maybe in search tree(be only the second best!)
@@ -1086,7 +1988,7 @@ int64_t Map::evaluateForPlayingPhase(uint8_t player)
 			rating[(getPlayerStoneOwnership(state)+expectedPlayerOffset-1)%getAmountOfPlayers()]+=getStabilityRating(cell);
 			if(isFrontierStone(cell))
 			{
-				rating[(getPlayerStoneOwnership(state)+expectedPlayerOffset-1)%getAmountOfPlayers()]+=WEIGHT_Frontier*existentCell[cell].influence;
+				rating[(getPlayerStoneOwnership(state)+expectedPlayerOffset-1)%getAmountOfPlayers()]+=WEIGHT_Frontier*topology->existentCell[cell].influence;
 			}
 		}
 	}
@@ -1130,14 +2032,9 @@ int64_t Map::evaluateForBombingPhase(uint8_t player)
 	memset(numberOfStones, 0, getAmountOfPlayers()*sizeof(int));
 
 	// Count the amount of cells owned for each player
-	unsigned char cell;
-	for(int i = 0; i < getAmountOfCells(); i++)
+	for(int colour=1; colour<=getAmountOfPlayers(); ++colour)
 	{
-		cell=board[i];
-		if(cell!=NO_STONE && cell>=1 && cell<=getAmountOfPlayers())
-		{
-			numberOfStones[cell-1]++;
-		}
+		numberOfStones[colour-1] = topology->countBits(getBitboard(HORIZONTAL, colour));
 	}
 
 	int stonesOwnedByUs = numberOfStones[playerMap[player]-1];
@@ -1180,13 +2077,9 @@ int64_t Map::evaluateForEndOfGame(uint8_t player)
 	int stoneCount[MAX_PLAYER+1];
 	memset(stoneCount, 0, sizeof(int)*(MAX_PLAYER+1));
 
-	for(int cell=0; cell<getAmountOfCells(); ++cell)
+	for(uint8_t colour=1; colour<=getAmountOfPlayers(); ++colour)
 	{
-		if((board[cell]!=0) && (board[cell]<MAX_PLAYER))
-		{
-			stoneCount[playerMap[(uint8_t)board[cell]]]++;
-		}
-
+		stoneCount[playerMap[colour]] += topology->countBits(getBitboard(HORIZONTAL, colour));
 	}
 
 	int amountOfPlayersWithMoreStones=0;
@@ -1247,6 +2140,31 @@ int Map::getAmountOfBombs(uint8_t player)
 	return numberOfBombs[player];
 }
 
+/**
+ * Returns a key which identifies the position for the transposition table of the search.
+ * Positions with the same key lead, with high probability, to the same moves and ratings.
+ * Besides the board, the player map and the override stones and bombs of every player,
+ * the key contains the player to move, the phase, whether override stones are considered
+ * and the order in which the players move.
+ *
+ * @param player		 - The player who moves next
+ * @param isPlayingPhase - True in the playing phase, false in the bombing phase
+ * @return The hash key of the position
+ */
+uint64_t Map::getHashKey(uint8_t player, bool isPlayingPhase)
+{
+	uint64_t key = hashKey ^ turnOrderKey ^ getZobristKey(ZOBRIST_TURN, player);
+	if(!isPlayingPhase)
+	{
+		key ^= getZobristKey(ZOBRIST_PHASE, 0);
+	}
+	if(!toConsiderOverrideStones)
+	{
+		key ^= getZobristKey(ZOBRIST_OVERRIDE, 0);
+	}
+	return key;
+}
+
 /**
  * Getter function for the amount of inversion stones, 
  * that are expected to be reached until the end of the game.
@@ -1261,15 +2179,11 @@ int Map::getAmountOfInversionStones()
  */
 int Map::getScore(uint8_t playerID){
 	int stoneCount[MAX_PLAYER+1];
-	memset(stoneCount, 0, sizeof(int)*MAX_PLAYER);
+	memset(stoneCount, 0, sizeof(int)*(MAX_PLAYER+1));
 
-	for(int i=0; i<getAmountOfCells(); i++)
+	for(uint8_t colour=1; colour<=getAmountOfPlayers(); ++colour)
 	{
-		if((board[i]!=0) && (board[i]<=MAX_PLAYER))
-		{
-			stoneCount[getPlayerStoneOwnership(board[i])]++;
-		}
-
+		stoneCount[getPlayerStoneOwnership(colour)] += topology->countBits(getBitboard(HORIZONTAL, colour));
 	}
 
 	int res=0;
@@ -1307,252 +2221,671 @@ int Map::getScore(uint8_t playerID){
 	}
 }
 
-/////////////////////////////////////////
-////			     				 ////
-////  PRIVATE METHODES OF MAP CLASS  ////
-////                    			 ////
-/////////////////////////////////////////
-
 /**
- * Checks wether a certain stone is likely to be reached during a game or not.
+ * Determines all cells on which the player could place a stone without using an override stone,
+ * and if requested the stones the player could override because stones would be captured.
+ * The rays are followed for all cells at once with the rotated bitboards,
+ * only cells with rays through <->-transitions get checked one by one.
+ * Expansion stones can be overridden without capturing, they are only listed if they capture.
  *
- * @param cell - The cell that should be analyzed for reachability
- * @return True if the cell is likely to be reached, false otherwise.
+ * @param player        - The player for whom the moves are searched
+ * @param moves         - A bitboard (in the compacted cell order) which is set to the cells with a valid move
+ * @param overrideMoves - A bitboard which is set to the stones whose override captures, NULL to skip them
+ * @return The amount of cells with a valid move, without the override moves
  */
-bool Map::isStoneReachable(uint16_t cell)
+int Map::getMobility(uint8_t player, uint64_t* moves, uint64_t* overrideMoves)
 {
-	bool hasLineWithMoreThanThreeElements=false;
-	for(int d=0; d<4; ++d)
+	uint8_t curPlayer = playerMap[player];
+
+	memset(moves, 0, topology->bitboardWordCount*sizeof(uint64_t));
+	if(overrideMoves)
 	{
-		if(cellsOnLine[existentCell[cell].lineIndex[d]].size()>3)
-		{
-			hasLineWithMoreThanThreeElements=true;
-			break;
-		}
+		memset(overrideMoves, 0, topology->bitboardWordCount*sizeof(uint64_t));
 	}
-	if(!hasLineWithMoreThanThreeElements)
+
+	if(curPlayer<1 || curPlayer>getAmountOfPlayers())
 	{
-		return false;
+		return 0;
 	}
 
-	bool gotVisited[getAmountOfCells()];
-	memset(gotVisited, false, getAmountOfCells()*sizeof(bool));
-
-	queue<uint16_t> toExamine;
-
-	toExamine.push(cell);
-
-	uint16_t next;
+	int wordCount = topology->bitboardWordCount;
+	uint64_t opponents[wordCount];
+	uint64_t line[wordCount];
+	uint64_t next[wordCount];
+	uint64_t found[wordCount];
+	uint64_t foundOverride[wordCount];
 
-	while(!toExamine.empty())
+	for(int orientation=0; orientation<LINE_COUNT; ++orientation)
 	{
-		next=toExamine.front();
-		toExamine.pop();
+		uint64_t* own = getBitboard(orientation, curPlayer);
+		uint64_t* free = getBitboard(orientation, 0);
 
-		if(next!= NO_CELL && !gotVisited[next])
+		// Every existing cell that neither ends a ray nor belongs to the player can be captured
+		int ownFirst=wordCount, ownLast=-1;
+		for(int w=0; w<wordCount; ++w)
 		{
-			gotVisited[next]=true;
-
-			for(int dir=0; dir<DIRECTION_COUNT; ++dir)
+			opponents[w] = ~(own[w] | free[w]);
+			found[w] = 0;
+			foundOverride[w] = 0;
+			if(own[w])
 			{
-				toExamine.push(existentCell[next].neighbour[dir]);
+				ownFirst = min(ownFirst, w);
+				ownLast = w;
 			}
+		}
+		if(getAmountOfCells()%64 != 0)
+		{
+			opponents[wordCount-1] &= ((uint64_t)1 << (getAmountOfCells()%64)) - 1;
+		}
 
-			char state=getState(next);
-			if(state!=0 && state<=MAX_PLAYER)
+		// Walk from the own stones over the opponents until a free cell is reached, in both directions of the line.
+		// Every stone reached behind at least one opponent can be overridden.
+		// Only the words between first and last hold bits of the walk, all others of line are 0.
+		for(uint8_t dir=orientation; dir<DIRECTION_COUNT && ownLast>=0; dir+=LINE_COUNT)
+		{
+			memset(line, 0, wordCount*sizeof(uint64_t));
+			int first = max(ownFirst-1, 0);
+			int last = min(ownLast+1, wordCount-1);
+			topology->shiftBitboard(own, line, dir, first, last);
+
+			while(first<=last)
 			{
-				int count=0;
-				for(int dir=0; dir<DIRECTION_COUNT; ++dir)
+				int lineFirst=wordCount, lineLast=-1;
+				for(int w=first; w<=last; ++w)
 				{
-					char neigbourState = getState(existentCell[next].neighbour[dir]);
-					if(neigbourState!=0 && (neigbourState<= MAX_PLAYER || neigbourState=='x') && neigbourState!=state)
+					line[w] &= opponents[w];
+					if(line[w])
 					{
-						count++;
+						lineFirst = min(lineFirst, w);
+						lineLast = w;
 					}
 				}
-				if(count>1)
+				if(lineLast<0)
 				{
-					return true;
+					break;
 				}
-			}
-		}
-	}
 
-	return false;
-}
-
-/**
- * Associates a score to the stability of the stone placed on the cell.
- *
- * @param cell - The cell, on which the stone is placed for which the stability should be determined
- * @return A score representing the stability of the stone on the cell
- */
-int Map::getStabilityRating(uint16_t cell){
+				first = max(lineFirst-1, 0);
+				last = min(lineLast+1, wordCount-1);
+				topology->shiftBitboard(line, next, dir, first, last);
 
-	int counter=0;
-	for(int l=0; l<LINE_COUNT; ++l){
-		if(isStoneStable[LINE_COUNT*cell+l])
-		{
-			counter++;
+				for(int w=first; w<=last; ++w)
+				{
+					found[w] |= next[w] & free[w];
+					foundOverride[w] |= next[w] & ~free[w];
+					line[w] = next[w];
+				}
+			}
 		}
-	}
-
-	int score;
-	if(counter==0)
-	{
-		score=15*existentCell[cell].influence;
-	}
-	else if(counter==1)
-	{
-		score=25*existentCell[cell].influence;//*=WEIGHT_stabilityRise;
-	}
-	else if(counter==2)
-	{
-		score=60*existentCell[cell].influence;//*=WEIGHT_stabilityRise;
-	}
-	else if(counter==3)
-	{
-		score=120*existentCell[cell].influence;//*=WEIGHT_stabilityRise;
-	}
-	else
-	{
-		score=400*existentCell[cell].influence;//*=WEIGHT_stabilityRise;
-	}
 
-	int max=0;
-	for(int dir=0; dir<DIRECTION_COUNT; ++dir){
-		int neighbour = existentCell[cell].neighbour[dir];
-		if(neighbour!=NO_CELL)
+		// Translate the found cells back to the compacted cell order
+		for(int w=0; w<topology->bitboardWordCount; ++w)
 		{
-			if(board[neighbour]=='b'){
-				return -400*WEIGHT_OverrideStones;
+			uint64_t word = found[w];
+			while(word)
+			{
+				uint16_t cell = topology->bitToCell[orientation][64*w + __builtin_ctzll(word)];
+				moves[cell>>6] |= (uint64_t)1 << (cell&63);
+				word &= word-1;
 			}
-			if(!(board[neighbour]>0 && board[neighbour]<=MAX_PLAYER) && existentCell[cell].baseStability[dir]>max){
-				max = existentCell[cell].baseStability[dir];
+
+			word = overrideMoves ? foundOverride[w] : 0;
+			while(word)
+			{
+				uint16_t cell = topology->bitToCell[orientation][64*w + __builtin_ctzll(word)];
+				overrideMoves[cell>>6] |= (uint64_t)1 << (cell&63);
+				word &= word-1;
 			}
 		}
 	}
 
-	if(max>counter){
-
-		if(max==1)
-		{
-			score=-25*existentCell[cell].influence;//*=WEIGHT_stabilityRise;
-		}
-		else if(max==2)
-		{
-			score=-60*existentCell[cell].influence;//*=WEIGHT_stabilityRise;
-		}
-		else if(max==3)
+	// Rays through transitions do not follow the bit order, so check those cells individually.
+	// Only candidate cells can have a valid move, as a move needs a neighbouring stone.
+	uint64_t* free = getBitboard(HORIZONTAL, 0);
+	uint64_t* candidates = getBitboard(LINE_COUNT, CANDIDATE_CELLS);
+	for(int w=0; w<topology->bitboardWordCount; ++w)
+	{
+		uint64_t word = topology->transitionCells[w] & candidates[w] & free[w] & ~moves[w];
+		while(word)
 		{
-			score=-120*existentCell[cell].influence;//*=WEIGHT_stabilityRise;
+			uint16_t cell = 64*w + __builtin_ctzll(word);
+			if(hasCaptures(cell, player))
+			{
+				moves[w] |= (uint64_t)1 << (cell&63);
+			}
+			word &= word-1;
 		}
-		else
+
+		word = overrideMoves ? topology->transitionCells[w] & candidates[w] & ~free[w] & ~overrideMoves[w] : 0;
+		while(word)
 		{
-			score=-400*existentCell[cell].influence;//*=WEIGHT_stabilityRise;
+			uint16_t cell = 64*w + __builtin_ctzll(word);
+			if(isStone(board[cell]) && hasCaptures(cell, player))
+			{
+				overrideMoves[w] |= (uint64_t)1 << (cell&63);
+			}
+			word &= word-1;
 		}
 	}
-	return score;
+
+	return topology->countBits(moves);
 }
 
 /**
- * Checks whether a cell is stable or not.
+ * Returns the next cell after the given one on which a move might be possible.
+ * In the playing phase only the candidate cells are returned (stones and the empty and special cells next
+ * to a stone), in the bombing phase every cell. Iterating over them leaves out the cells far away from
+ * all stones, on which a move can never be valid.
  *
- * @param cell - The cell that should be tested for its stability
- * @return True if cell is stable, false otherwise
+ * @param cell           - The cell after which the search starts, -1 to get the first candidate cell
+ * @param isPlayingPhase - True in the playing phase, false in the bombing phase
+ * @return The index of the next candidate cell, or getAmountOfCells() if there is none
  */
-inline bool Map::isStable(uint16_t cell)
+int Map::getNextCandidateCell(int cell, bool isPlayingPhase)
 {
-	if(cell==NO_CELL || board[cell]==0 || board[cell]>MAX_PLAYER)
+	++cell;
+	if(cell>=getAmountOfCells())
 	{
-		return false;
+		return getAmountOfCells();
+	}
+	if(!isPlayingPhase)
+	{
+		return cell;
 	}
 
-	for(int i=0; i<4; i++){
-		if(!isStoneStable[4*cell+i])
+	uint64_t* candidates = getBitboard(LINE_COUNT, CANDIDATE_CELLS);
+	int w = cell>>6;
+	uint64_t word = candidates[w] & (~(uint64_t)0 << (cell&63));
+
+	while(word==0)
+	{
+		if(++w>=topology->bitboardWordCount)
 		{
-			return false;
+			return getAmountOfCells();
 		}
+		word = candidates[w];
 	}
-	return true;
+
+	return 64*w + __builtin_ctzll(word);
 }
 
 /**
- * Checks whether a stone is a frontier stone or not. 
- * A frontier stone is a stone that has at least one free cell as neighbour.
+ * Collects all valid moves of a player without changing the board.
+ * Choice cells are listed once for every player that can be chosen (choice 1 to amount of players),
+ * bonus cells once for the bomb (choice 20) and once for the override stone (choice 21).
+ * Override moves are only listed if the player has override stones and they are considered (see setConsiderOverrideStones()).
+ * The cells with a valid move are found word-parallel with getMobility().
+ * The moves are ordered by their cell.
  *
- * @param cell - The cell on which the stone, for which should be determined if it is a frontier cell or not, is placed
- * @return True if the stone on the cell is a frontier stone, false otherwise
+ * @param player         - The player whose moves are collected
+ * @param isPlayingPhase - True in the playing phase, false in the bombing phase
+ * @param moves          - The list that is filled with the moves
  */
-inline bool Map::isFrontierStone(uint16_t cell){
-	int neighbour;
-	for(int dir=0; dir<DIRECTION_COUNT; ++dir)
+void Map::generateMoves(uint8_t player, bool isPlayingPhase, MoveList& moves)
+{
+	moves.count=0;
+
+	if(!isPlayingPhase)
 	{
-		neighbour = existentCell[cell].neighbour[dir];
-		if(neighbour!=NO_CELL)
+		if(numberOfBombs[player]>0)
 		{
-			if(board[neighbour]==0 || (board[neighbour]>MAX_PLAYER && board[neighbour]!='x'))
+			// Every cell that has not been bombed away can be bombed
+			uint64_t* holes = getBitboard(LINE_COUNT, HOLE_CELLS);
+			for(int w=0; w<topology->bitboardWordCount; ++w)
 			{
-				return true;
+				uint64_t word = ~holes[w];
+				if(w==topology->bitboardWordCount-1 && getAmountOfCells()%64 != 0)
+				{
+					word &= ((uint64_t)1 << (getAmountOfCells()%64)) - 1;
+				}
+
+				while(word)
+				{
+					addMove(moves, 64*w + __builtin_ctzll(word), player, 0);
+					word &= word-1;
+				}
 			}
 		}
+		return;
 	}
 
-	return false;
-}
+	bool canOverride = (overrideStones[player]>0) && toConsiderOverrideStones;
 
+	uint64_t valid[topology->bitboardWordCount];
+	uint64_t overridable[topology->bitboardWordCount];
+	getMobility(player, valid, canOverride ? overridable : NULL);
 
-/**
- * Returns whether placing a stone of a specified player to the start cell would result in a valid move.
- * Ignoring override stones.
- *
+	// Expansion stones can always be overridden, other stones only if stones get captured
+	if(canOverride)
+	{
+		uint64_t* special = getBitboard(LINE_COUNT, SPECIAL_CELLS);
+		uint64_t* free = getBitboard(HORIZONTAL, 0);
+		for(int w=0; w<topology->bitboardWordCount; ++w)
+		{
+			valid[w] |= overridable[w] | (special[w] & ~free[w]);
+		}
+	}
+
+	for(int w=0; w<topology->bitboardWordCount; ++w)
+	{
+		uint64_t word = valid[w];
+		while(word)
+		{
+			uint16_t cell = 64*w + __builtin_ctzll(word);
+			word &= word-1;
+
+			char state = board[cell];
+			if(state=='c')
+			{
+				for(int p=1; p<=getAmountOfPlayers(); ++p)
+				{
+					addMove(moves, cell, player, p);
+				}
+			}
+			else if(state=='b')
+			{
+				addMove(moves, cell, player, 20);
+				addMove(moves, cell, player, 21);
+			}
+			else
+			{
+				addMove(moves, cell, player, 0);
+			}
+		}
+	}
+}
+
+/**
+ * Returns the next player to be considered.
+ *
+ * @param lastPlayer
+ * @return	The id of the player that should do the next move
+ */
+uint8_t Map::getNextPlayer(uint8_t lastPlayer)
+{
+	int lastIndex = find(nextPlayers, nextPlayers+amountOfConsideredPlayers, lastPlayer) - nextPlayers;
+	return nextPlayers[(lastIndex+1)%amountOfConsideredPlayers];
+}
+
+/**
+ * Getter method for the amount of players that are considered while doing the search for the next move.
+ *
+ * @return The amount of players in the list of next Players
+ */
+uint8_t Map::getAmountOfConsideredPlayers()
+{
+	return amountOfConsideredPlayers;
+}
+
+/**
+ * Disqualifies a player for the rest of the game played on this map.
+ * NOTE: Param player starts with player 1 as the number 1!
+ *
+ * @param player - The slot of the player that should get disqualified.
+ */
+void Map::disqualifyPlayer(uint8_t player)
+{
+	amountOfActivePlayers--;
+	disqualified[player] = true;
+	updateTurnOrderKey();
+}
+
+/**
+ * Getter function for getting the disqualification status of the player.
+ * NOTE: Param player starts with player 1 as the number 1!
+ *
+ * @param player - The player whose disqualification status should get checked
+ * @return Returns true if the player has been disqualified, false otherwise
+ */
+bool Map::isDisqualified(uint8_t player)
+{
+	return disqualified[player];
+}
+
+/**
+ * Getter function for the amount of players that have not been disqualified.
+ *
+ * @return The amount of players that have not been disqualified
+ */
+uint8_t Map::getAmountOfActivePlayers()
+{
+	return amountOfActivePlayers;
+}
+
+/**
+ * Getter function for the width of the board.
+ *
+ * @return The width of the board
+ */
+uint16_t Map::getWidth()
+{
+	return topology->width;
+}
+
+/**
+ * Getter function for the height of the board.
+ *
+ * @return The height of the board
+ */
+uint16_t Map::getHeight()
+{
+	return topology->height;
+}
+
+/**
+ * Returns the offset of a cell at the coordinates (x,y).
+ *
+ * @param x - The x coordinate of the cell that should get returned
+ * @param y - The y coordinate of the cell that should get returned
+ * @return The offset of the cell for the intern arrays
+ */
+uint16_t Map::getOffset(uint16_t x, uint16_t y)
+{
+	return topology->offsetMap[x][y];
+}
+
+/**
+ * Computes the x and y coordinate for a give offset.
+ *
+ * @param x - Pointer to integer that gets set to the x coordinate of the cell
+ * @param y - Pointer to integer that gets set to the y coordinate of the cell
+ * @param offset - The offset of the cell which coordinates are requested
+ */
+void Map::reverseOffset(int* x, int* y, uint16_t offset)
+{
+	*x = topology->reverseOffsetX[offset];
+	*y = topology->reverseOffsetY[offset];
+}
+
+/**
+ * Getter function for the amount of cells on the board.
+ *
+ * @return The amount of cells on the board
+ */
+uint16_t Map::getAmountOfCells()
+{
+	return topology->cellcount;
+}
+
+/**
+ * Getter function for the highest amount of cells that can get recoloured by a single move.
+ * Buffers passed to Map::getMoveCaptures need at least that many entries.
+ *
+ * @return The highest amount of cells a move can recolour
+ */
+int Map::getMaximumCaptureCount()
+{
+	return topology->maximumCaptureCount;
+}
+
+/**
+ * Getter function for the highest amount of moves a player can have in one position.
+ * Buffers of a MoveList need at least that many entries.
+ *
+ * @return The highest amount of moves in one position
+ */
+int Map::getMaximumMoveCount()
+{
+	return topology->maximumMoveCount;
+}
+
+/**
+ * Getter function for the amount of players.
+ *
+ * @return The amount of players that started the game
+ */
+uint8_t Map::getAmountOfPlayers()
+{
+	return topology->amountOfPlayers;
+}
+
+/////////////////////////////////////////
+////			     				 ////
+////  PRIVATE METHODES OF MAP CLASS  ////
+////                    			 ////
+/////////////////////////////////////////
+
+/**
+ * Checks wether a certain stone is likely to be reached during a game or not.
+ *
+ * @param cell - The cell that should be analyzed for reachability
+ * @return True if the cell is likely to be reached, false otherwise.
+ */
+bool Map::isStoneReachable(uint16_t cell)
+{
+	bool hasLineWithMoreThanThreeElements=false;
+	for(int d=0; d<4; ++d)
+	{
+		if(topology->cellsOnLine[topology->existentCell[cell].lineIndex[d]].size()>3)
+		{
+			hasLineWithMoreThanThreeElements=true;
+			break;
+		}
+	}
+	if(!hasLineWithMoreThanThreeElements)
+	{
+		return false;
+	}
+
+	bool gotVisited[getAmountOfCells()];
+	memset(gotVisited, false, getAmountOfCells()*sizeof(bool));
+
+	queue<uint16_t> toExamine;
+
+	toExamine.push(cell);
+
+	uint16_t next;
+
+	while(!toExamine.empty())
+	{
+		next=toExamine.front();
+		toExamine.pop();
+
+		if(next!= NO_CELL && !gotVisited[next])
+		{
+			gotVisited[next]=true;
+
+			for(int dir=0; dir<DIRECTION_COUNT; ++dir)
+			{
+				toExamine.push(topology->existentCell[next].neighbour[dir]);
+			}
+
+			char state=getState(next);
+			if(state!=0 && state<=MAX_PLAYER)
+			{
+				int count=0;
+				for(int dir=0; dir<DIRECTION_COUNT; ++dir)
+				{
+					if(topology->existentCell[next].neighbour[dir]==NO_CELL)
+					{
+						continue;
+					}
+
+					char neigbourState = getState(topology->existentCell[next].neighbour[dir]);
+					if(neigbourState!=0 && (neigbourState<= MAX_PLAYER || neigbourState=='x') && neigbourState!=state)
+					{
+						count++;
+					}
+				}
+				if(count>1)
+				{
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Associates a score to the stability of the stone placed on the cell.
+ *
+ * @param cell - The cell, on which the stone is placed for which the stability should be determined
+ * @return A score representing the stability of the stone on the cell
+ */
+int Map::getStabilityRating(uint16_t cell){
+
+	int counter=stableLineCount[cell];
+
+	int score;
+	if(counter==0)
+	{
+		score=15*topology->existentCell[cell].influence;
+	}
+	else if(counter==1)
+	{
+		score=25*topology->existentCell[cell].influence;//*=WEIGHT_stabilityRise;
+	}
+	else if(counter==2)
+	{
+		score=60*topology->existentCell[cell].influence;//*=WEIGHT_stabilityRise;
+	}
+	else if(counter==3)
+	{
+		score=120*topology->existentCell[cell].influence;//*=WEIGHT_stabilityRise;
+	}
+	else
+	{
+		score=400*topology->existentCell[cell].influence;//*=WEIGHT_stabilityRise;
+	}
+
+	int max=0;
+	for(int dir=0; dir<DIRECTION_COUNT; ++dir){
+		int neighbour = topology->existentCell[cell].neighbour[dir];
+		if(neighbour!=NO_CELL)
+		{
+			if(board[neighbour]=='b'){
+				return -400*topology->overrideStoneWeight;
+			}
+			if(!(board[neighbour]>0 && board[neighbour]<=MAX_PLAYER) && topology->existentCell[cell].baseStability[dir]>max){
+				max = topology->existentCell[cell].baseStability[dir];
+			}
+		}
+	}
+
+	if(max>counter){
+
+		if(max==1)
+		{
+			score=-25*topology->existentCell[cell].influence;//*=WEIGHT_stabilityRise;
+		}
+		else if(max==2)
+		{
+			score=-60*topology->existentCell[cell].influence;//*=WEIGHT_stabilityRise;
+		}
+		else if(max==3)
+		{
+			score=-120*topology->existentCell[cell].influence;//*=WEIGHT_stabilityRise;
+		}
+		else
+		{
+			score=-400*topology->existentCell[cell].influence;//*=WEIGHT_stabilityRise;
+		}
+	}
+	return score;
+}
+
+/**
+ * Checks whether a cell is stable or not.
+ *
+ * @param cell   - The cell that should be tested for its stability
+ * @param offset - 0 for the current stability, LINE_COUNT*getAmountOfCells() for the one a reset would give
+ * @return True if cell is stable, false otherwise
+ */
+inline bool Map::isStable(uint16_t cell, uint32_t offset)
+{
+	if(cell==NO_CELL || board[cell]==0 || board[cell]>MAX_PLAYER)
+	{
+		return false;
+	}
+
+	return stableLineCount[offset/LINE_COUNT + cell]==LINE_COUNT;
+}
+
+/**
+ * Checks whether a stone is a frontier stone or not. 
+ * A frontier stone is a stone that has at least one free cell as neighbour.
+ *
+ * @param cell - The cell on which the stone, for which should be determined if it is a frontier cell or not, is placed
+ * @return True if the stone on the cell is a frontier stone, false otherwise
+ */
+inline bool Map::isFrontierStone(uint16_t cell){
+	int neighbour;
+	for(int dir=0; dir<DIRECTION_COUNT; ++dir)
+	{
+		neighbour = topology->existentCell[cell].neighbour[dir];
+		if(neighbour!=NO_CELL)
+		{
+			if(board[neighbour]==0 || (board[neighbour]>MAX_PLAYER && board[neighbour]!='x'))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+
+/**
+ * Returns whether placing a stone of a specified player to the start cell would result in a valid move.
+ * Ignoring override stones.
+ *
  * @param start  - The offset of the cell where a stone should be placed on
  * @param player - The player for whom the move is tested
  * @return	True if the move is valid, false if not
  */
 bool Map::isMoveValid(uint16_t start, uint8_t player)
 {
-	int curDirection;
-	int curCell;
-	int prevCell;
-	int curPlayer;
-	int curBoardState;
-
 	if(start==NO_CELL)
 	{
 		return false;
 	}
 
-	curPlayer = playerMap[player];
-	curBoardState=board[start];
+	char curBoardState = board[start];
 
 	if(curBoardState!=0 && curBoardState!='b' && curBoardState!='c' && curBoardState!='i')
 	{
 		return false;
 	}
 
-	int distance=0;
+	return hasCaptures(start, player);
+}
 
-	for(int dir=0; dir<DIRECTION_COUNT; ++dir) // Check all directions
+/**
+ * Returns whether a stone of the player on the start cell would capture at least one stone,
+ * independent of the state of the start cell.
+ *
+ * @param start  - The offset of the cell where a stone should be placed on
+ * @param player - The player for whom the move is tested
+ * @return	True if at least one stone would be captured, false if not
+ */
+bool Map::hasCaptures(uint16_t start, uint8_t player)
+{
+	char curPlayer = playerMap[player];
+
+#ifdef RAY_GATHER
+	if(isRayGatherSupported)
 	{
-		curCell = existentCell[start].neighbour[dir];
-		curDirection = existentCell[start].direction[dir];
+		return topology->hasCapturesGathered(board, start, curPlayer);
+	}
+#endif
 
-		distance=0;
+	for(int dir=0; dir<DIRECTION_COUNT; ++dir) // Check all directions
+	{
+		const uint16_t* first = topology->rayCells + topology->rayBegin[DIRECTION_COUNT*start+dir];
+		const uint16_t* last = topology->rayCells + topology->rayBegin[DIRECTION_COUNT*start+dir+1];
+		const uint16_t* cur = first;
 
-		// while (next cell still a player or expansion cell AND not the start cell)
-		while(curCell != NO_CELL && curCell != start && board[curCell] != curPlayer
-			&& board[curCell] != 'c' && board[curCell] != 0
-			&& board[curCell] != 'b' && board[curCell] != 'i')
+		// while (next cell still a player or expansion cell AND not the end of the ray)
+		while(cur != last && !isRayEnd(board[*cur], curPlayer))
 		{
-			distance++;
-			prevCell = curCell;
-			curCell = existentCell[prevCell].neighbour[curDirection];		// Get the next cell with the saved direction
-			curDirection = existentCell[prevCell].direction[curDirection];	// Get the new direction
+			++cur;
 		}
 
 		// Check if the current cell builds a line with the placed cell for the player
-		if(curCell != NO_CELL && board[curCell] == curPlayer && curCell!=start && distance>=1)
+		if(cur != last && cur != first && board[*cur] == curPlayer)
 		{
 			return true;
 		}
@@ -1582,330 +2915,667 @@ inline uint8_t Map::getPlayerStoneOwnership(uint8_t state)
 }
 
 /**
- * Updates which stones are stable depending on the stable neighbours
+ * Updates which stones are stable depending on the stable neighbours.
+ * Every stable stone is put on a worklist once and spreads its stability from there, see spreadStableState().
+ */
+void Map::adaptStableState()
+{
+	stabilityWorklist.clear();
+	for(int cell=0; cell<getAmountOfCells(); ++cell)
+	{
+		if(isStable(cell))
+		{
+			stabilityWorklist.push_back(cell);
+		}
+	}
+
+	spreadStableState(0);
+}
+
+/**
+ * Clears the flags of the current stability that were only spread through moves, so that it is equal
+ * to the stability recounted from the border of the map and the filled lines. This is needed whenever the
+ * colours of stones change in a way stability does not protect from (override stones, choice and inversion).
+ */
+void Map::resetStableState()
+{
+	uint32_t resetOffset = LINE_COUNT*getAmountOfCells();
+
+	for(vector<uint32_t>::iterator it=stabilityDifferences.begin(); it!=stabilityDifferences.end(); ++it)
+	{
+		if(isStoneStable[*it] && !isStoneStable[resetOffset + *it])
+		{
+			setStoneStable(*it, false);
+		}
+	}
+
+	// The list is still needed to take back a recorded move
+	if(!isRecording)
+	{
+		stabilityDifferences.clear();
+	}
+}
+
+/**
+ * Checks whether a cell is stable on a line without the help of its neighbours, which is the case
+ * if it lies at the border of the map on that line, or if the line contains no free cells anymore.
+ *
+ * @param cell - The cell that should be tested
+ * @param line - The orientation of the line, from 0 to 3
+ * @return True if the cell is stable on that line by itself, false otherwise
+ */
+inline bool Map::isBaseStable(uint16_t cell, int line)
+{
+	return (topology->existentCell[cell].neighbour[line]==NO_CELL) || (topology->existentCell[cell].neighbour[line+4]==NO_CELL)
+		|| (amountOfFreeCellsOnLine[topology->existentCell[cell].lineIndex[line]]==0);
+}
+
+/**
+ * Removes the flags a reset would give, which may depend on the colour of the cells that are
+ * recoloured by a move. Has to be called before the cells are recoloured. Every stable cell
+ * that loses a flag may have spread its stability, so its neighbours are checked as well.
+ * The cells that lose flags are collected for updateStableState().
+ *
+ * @param start        - The cell on which the stone is placed
+ * @param captures     - The cells that get recoloured by the move
+ * @param captureCount - The amount of entries in captures
  */
-void Map::adaptStableState(){
+void Map::invalidateStableState(uint16_t start, uint16_t* captures, int captureCount)
+{
+	uint32_t resetOffset = LINE_COUNT*getAmountOfCells();
 
-	// Define stable stones
-	bool hasChanged=true;
+	stabilityChangedCells.clear();
+	stabilityWorklist.clear();
 
-	while(hasChanged)
+	for(int i=-1; i<captureCount; ++i)
 	{
-		hasChanged=false;
-		for(int cell=0; cell<getAmountOfCells(); ++cell)
+		uint16_t cell = (i<0) ? start : captures[i];
+
+		if(isStable(cell, resetOffset))
 		{
-			if(isStable(cell))
+			stabilityWorklist.push_back(cell);
+		}
+
+		for(int line=0; line<LINE_COUNT; ++line)
+		{
+			if(!isBaseStable(cell, line))
 			{
-				for(int dir=0; dir<DIRECTION_COUNT; ++dir)
+				setStoneStable(resetOffset + LINE_COUNT*cell + line, false);
+			}
+		}
+	}
+
+	while(!stabilityWorklist.empty())
+	{
+		uint16_t cell = stabilityWorklist.back();
+		stabilityWorklist.pop_back();
+
+		for(int dir=0; dir<DIRECTION_COUNT; ++dir)
+		{
+			int neighbour=topology->existentCell[cell].neighbour[dir];
+			if((neighbour!=NO_CELL) && (board[neighbour]==board[cell]))
+			{
+				int line = topology->existentCell[cell].direction[dir]%LINE_COUNT;
+				if(isStoneStable[resetOffset + LINE_COUNT*neighbour + line] && !isBaseStable(neighbour, line))
 				{
-					int neighbour=existentCell[cell].neighbour[dir];
-					if((neighbour!=NO_CELL) && (board[neighbour]==board[cell]))
+					if(isStable(neighbour, resetOffset))
 					{
-						if(!isStoneStable[LINE_COUNT*neighbour + (existentCell[cell].direction[dir]%LINE_COUNT)])
-						{
-							isStoneStable[LINE_COUNT*neighbour + (existentCell[cell].direction[dir]%LINE_COUNT)]=true;
-							hasChanged=true;
-						}
+						stabilityWorklist.push_back(neighbour);
 					}
+					setStoneStable(resetOffset + LINE_COUNT*neighbour + line, false);
+					stabilityChangedCells.push_back(neighbour);
 				}
 			}
 		}
 	}
 }
 
-void Map::resetStableState()
+/**
+ * Spreads the stability after a move was made, starting from the recoloured cells and the cells that
+ * got new flags or lost them in invalidateStableState(). Such a cell spreads its stability if it is stable
+ * itself, and it may get stability from its stable neighbours. The flags a reset would give are updated
+ * first, so that the current flags can be compared to them.
+ *
+ * @param start        - The cell on which the stone was placed
+ * @param captures     - The cells that got recoloured by the move
+ * @param captureCount - The amount of entries in captures
+ */
+void Map::updateStableState(uint16_t start, uint16_t* captures, int captureCount)
 {
-	memset(amountOfFreeCellsOnLine,0,lineCount*sizeof(uint16_t));
+	stabilityChangedCells.push_back(start);
+	stabilityChangedCells.insert(stabilityChangedCells.end(), captures, captures+captureCount);
 
-	for(int i=0; i<lineCount; ++i)
+	uint32_t offsets[2] = {(uint32_t)LINE_COUNT*getAmountOfCells(), 0};
+	for(int i=0; i<2; ++i)
 	{
-		for(vector<int>::iterator it=cellsOnLine[i].begin(); it!=cellsOnLine[i].end(); ++it)
+		stabilityWorklist.clear();
+		for(vector<uint16_t>::iterator it=stabilityChangedCells.begin(); it!=stabilityChangedCells.end(); ++it)
 		{
-			if(board[*it]==0 || (board[*it]>MAX_PLAYER && board[*it]!='x') )
+			if(isStable(*it, offsets[i]))
+			{
+				stabilityWorklist.push_back(*it);
+			}
+
+			for(uint32_t link=topology->linkingBegin[*it]; link<topology->linkingBegin[*it+1]; ++link)
 			{
-				amountOfFreeCellsOnLine[i]++;
+				if(isStable(topology->linkingCells[link], offsets[i]))
+				{
+					stabilityWorklist.push_back(topology->linkingCells[link]);
+				}
 			}
 		}
+
+		spreadStableState(offsets[i]);
 	}
+}
 
-	// Set the base stability for every cell (=stability given by holes as direct neighbours)
-	// This is used to avoid placing a stone near to corners or walls
-	for(int cell=0; cell<getAmountOfCells(); ++cell)
+/**
+ * Spreads the stability from the stable cells in the worklist to their neighbours of the same colour,
+ * until no more flags change. A cell is only added when it becomes stable, so it spreads at most once.
+ *
+ * @param offset - 0 for the current stability, LINE_COUNT*getAmountOfCells() for the one a reset would give
+ */
+void Map::spreadStableState(uint32_t offset)
+{
+	while(!stabilityWorklist.empty())
 	{
-		for(int dir=0; dir<4; ++dir)
+		uint16_t cell = stabilityWorklist.back();
+		stabilityWorklist.pop_back();
+
+		for(int dir=0; dir<DIRECTION_COUNT; ++dir)
 		{
-			if((existentCell[cell].neighbour[dir]==NO_CELL) || (existentCell[cell].neighbour[dir+4]==NO_CELL))
-			{
-				isStoneStable[4*cell+dir]=true;
-			}
-			else if(amountOfFreeCellsOnLine[existentCell[cell].lineIndex[dir]]==0)
-			{
-				isStoneStable[4*cell+dir]=true;
-			}
-			else
+			int neighbour=topology->existentCell[cell].neighbour[dir];
+			if((neighbour!=NO_CELL) && (board[neighbour]==board[cell]))
 			{
-				isStoneStable[4*cell+dir]=false;
+				uint32_t index = offset + LINE_COUNT*neighbour + (topology->existentCell[cell].direction[dir]%LINE_COUNT);
+				if(!isStoneStable[index])
+				{
+					setStoneStable(index, true);
+					if(isStable(neighbour, offset))
+					{
+						stabilityWorklist.push_back(neighbour);
+					}
+				}
 			}
 		}
 	}
 }
 
 /**
- * Returns the offset of all the cells that would get recoloured.
+ * Collects the offset of all the cells that would get recoloured.
  * The offset may be included multiple times.
  *
- * @param start  - The offset of the cell that should get checked for re-colouring
- * @param player - The player for who it should get checked
- * @return	A vector of all the cells on which would get recoloured for that player
+ * @param start    - The offset of the cell that should get checked for re-colouring
+ * @param player   - The player for who it should get checked
+ * @param captures - A buffer with space for at least getMaximumCaptureCount() cells, which is filled with the cells that would get recoloured
+ * @return	The amount of cells that would get recoloured for that player
  */
-vector<int> Map::getMoveCaptures(uint16_t start, uint8_t player)
+int Map::getMoveCaptures(uint16_t start, uint8_t player, uint16_t* captures)
 {
-	uint8_t curPlayer = playerMap[player];
-
-	// Get all cells that have to be recoloured
-	uint8_t curDirection = 0, prevDirection = 0;
-	int curCell, prevCell;
-	vector<int> recolourList;
+	char curPlayer = playerMap[player];
+	int captureCount = 0;
 
 	// Check all directions
 	for(uint8_t dir=0; dir<DIRECTION_COUNT; ++dir)
 	{
-		curDirection = dir;
-		curCell = existentCell[start].neighbour[curDirection];
-		curDirection = existentCell[start].direction[curDirection];
-		prevCell = start;
+		const uint16_t* first = topology->rayCells + topology->rayBegin[DIRECTION_COUNT*start+dir];
+		const uint16_t* last = topology->rayCells + topology->rayBegin[DIRECTION_COUNT*start+dir+1];
+		const uint16_t* cur = first;
 
-		// while(next cell still a player or expansion cell AND not the start cell)
-		while(curCell != NO_CELL && curCell != start && board[curCell] != curPlayer
-			&& board[curCell] != 'c' && board[curCell] != 0
-			&& board[curCell] != 'b' && board[curCell] != 'i')
+		// while(next cell still a player or expansion cell AND not the end of the ray)
+		while(cur != last && !isRayEnd(board[*cur], curPlayer))
 		{
-			prevDirection = curDirection;									 // Save the current direction
-			prevCell	  = curCell;										 // Save the current cell
-			curDirection  = existentCell[prevCell].direction[prevDirection]; // Get the new direction
-			curCell 	  = existentCell[prevCell].neighbour[prevDirection]; // Get the next cell with the saved direction
+			++cur;
 		}
 
-		// Check if the current cell builds a line with the placed cell for the player
-		if(curCell != NO_CELL && curCell != start && board[curCell] == curPlayer)
-		{	
-			// Mark all cells that need to be recoloured
-			curDirection = (prevDirection + 4) % DIRECTION_COUNT; // Reverse direction to go backwards
-			curCell = prevCell;						// Choose the last cell as a valid one and is not a line start/end
-
-			while(curCell != start)
-			{
-				recolourList.push_back(curCell);								// Add to list for recolouring
-				prevDirection = curDirection;									// Save current direction
-				curDirection = existentCell[curCell].direction[curDirection];	// Get the new direction
-				curCell = existentCell[curCell].neighbour[prevDirection];		// Get the next cell with the saved direction
-			}
+		// Mark all cells between the start and an own stone for recolouring
+		if(cur != last && board[*cur] == curPlayer)
+		{
+			memcpy(captures+captureCount, first, (cur-first)*sizeof(uint16_t));
+			captureCount += cur-first;
 		}
 	}
 
-	return recolourList;
+	return captureCount;
 }
 
 /**
- * Deletes all necessary cells from the map.
+ * Marks all cells that get destroyed by a bomb.
  * The offset may be included multiple times.
  *
  * @param start - The offset of the cell where the bomb will be placed
  * @param depth - The depth of the bomb for which cells get deleted
+ * @param hit   - Contains for every cell the highest depth(+1) with which it was reached, 0 if it has not been hit
  */
-inline void Map::bombCell(uint16_t start, int depth)
+inline void Map::bombCell(uint16_t start, int depth, uint8_t* hit)
 {
-	if(start==NO_CELL || board[start]>=NO_STONE-bombExplosionRadius+depth)	// Nothing to destroy
+	if(start==NO_CELL || board[start]==NO_STONE || hit[start]>depth)	// Nothing to destroy
 	{
 		return;
 	}
 
-	board[start] = NO_STONE - bombExplosionRadius + depth;
+	hit[start] = depth+1;
 
 	if(depth > 0)
 	{
 		for(int dir=0; dir<DIRECTION_COUNT; ++dir)	// For every neighbour
 		{
-			bombCell(existentCell[start].neighbour[dir],depth-1);
+			bombCell(topology->existentCell[start].neighbour[dir], depth-1, hit);
 		}
 	}
 }
 
 /**
- * Add a new neighbour to the data structure
+ * Returns the bitboard of one slot.
  *
- * @param x1   - The x coordinate of the first cell to be linked
- * @param y1   - The y coordinate of the first cell to be linked
- * @param dir1 - The direction of the link from the perspective of the first cell
- * @param x2   - The x coordinate of the second cell to be linked
- * @param y2   - The y coordinate of the first second to be linked
- * @param dir2 - The direction of the link from the perspective of the second cell
+ * @param orientation - The line orientation of the bitboard, LINE_COUNT for the bitboards in compacted order only
+ * @param slot		  - The colour of the stones (0 for cells that end a ray) or the type of the compacted bitboard
+ * @return A pointer to the first word of the bitboard
  */
-void Map::addNeighbour(uint16_t x1, uint16_t y1, uint8_t dir1, uint16_t x2, uint16_t y2, uint8_t dir2)
+inline uint64_t* Map::getBitboard(int orientation, int slot)
 {
-	uint16_t cell1 = getOffset(x1, y1);
-	uint16_t cell2 = getOffset(x2, y2);
-	(existentCell[cell1]).neighbour[dir1] = cell2;
-	(existentCell[cell1]).direction[dir1] = (dir2+4) % DIRECTION_COUNT;
-	(existentCell[cell2]).neighbour[dir2] = cell1;
-	(existentCell[cell2]).direction[dir2] = (dir1+4) % DIRECTION_COUNT;
+	return bitboard + (orientation*(getAmountOfPlayers()+1) + slot)*topology->bitboardWordCount;
 }
 
-////////////////////////////
-////			     	////
-////  PUBLIC FUNCTIONS  ////
-////                    ////
-////////////////////////////
-
 /**
- * Set a flag whether override stones should be considered for the validation of playing phase move. 
- * This should be used to reduce the branching factor during move search. 
- * It is most likely that no override stones will be saved for the end of the game anyway.
+ * Sets the state of a cell and keeps the bitboards up to date.
+ * Every change of the board during the game has to be done through this method.
  *
- * @param toConsider - True if override stones should be considered, false otherwise
+ * @param cell  - The cell whose state changes
+ * @param state - The new state of the cell
  */
-void setConsiderOverrideStones(bool toConsider)
+inline void Map::setState(uint16_t cell, char state)
 {
-	toConsiderOverrideStones = toConsider;
+	if(board[cell]==state)
+	{
+		return;
+	}
+
+	if(isRecording)
+	{
+		cellJournal.push_back(make_pair(cell, board[cell]));
+	}
+
+	writeState(cell, state);
 }
 
 /**
- * Getter function for the flag that indicates if override stones are being considered.
+ * Changes the state of a cell without recording it, updating the bitboards and the candidate cells.
  *
- * @return True if override stones are being considered, false otherwise
+ * @param cell  - The cell whose state changes
+ * @param state - The new state of the cell
  */
-bool getConsiderOverrideStones()
+inline void Map::writeState(uint16_t cell, char state)
 {
-	return toConsiderOverrideStones;
+	bool wasStone = isStone(board[cell]);
+
+	// The ratings of the neighbours only depend on whether this cell holds a stone, a bonus or is free
+	markCellRatingOutdated(cell);
+	if(!(board[cell]>0 && board[cell]<=MAX_PLAYER && state>0 && state<=MAX_PLAYER))
+	{
+		for(uint32_t i=topology->linkingBegin[cell]; i<topology->linkingBegin[cell+1]; ++i)
+		{
+			markCellRatingOutdated(topology->linkingCells[i]);
+		}
+	}
+
+	updateBitboards(cell, board[cell], false);
+	updateBitboards(cell, state, true);
+	hashKey ^= topology->zobristKeys[cell*ZOBRIST_STATE_COUNT + topology->zobristState[(uint8_t)board[cell]]]
+			 ^ topology->zobristKeys[cell*ZOBRIST_STATE_COUNT + topology->zobristState[(uint8_t)state]];
+	board[cell] = state;
+
+	if(wasStone != isStone(state))
+	{
+		for(uint32_t i=topology->linkingBegin[cell]; i<topology->linkingBegin[cell+1]; ++i)
+		{
+			uint16_t linkingCell = topology->linkingCells[i];
+			stoneNeighbours[linkingCell] += wasStone ? -1 : 1;
+			updateCandidateState(linkingCell);
+		}
+	}
+	updateCandidateState(cell);
 }
 
 /**
- * Returns the next player to be considered.
+ * Adds a cell to the candidate cells or removes it from them, depending on its current state.
+ * Candidates are the stones, which can be overridden, and the empty and special cells next to
+ * at least one stone. Every valid move in the playing phase is made on a candidate cell.
  *
- * @param lastPlayer
- * @return	The id of the player that should do the next move
+ * @param cell - The cell that should be updated
  */
-uint8_t getNextPlayer(uint8_t lastPlayer)
+inline void Map::updateCandidateState(uint16_t cell)
 {
-	int lastIndex = find(nextPlayers.begin(), nextPlayers.end(), lastPlayer) - nextPlayers.begin();
-	return nextPlayers[(lastIndex+1)%nextPlayers.size()];
+	char state = board[cell];
+	bool isCandidate = isStone(state) || (state!=NO_STONE && stoneNeighbours[cell]>0);
+
+	uint64_t* word = getBitboard(LINE_COUNT, CANDIDATE_CELLS) + (cell>>6);
+	if(isCandidate)
+	{
+		*word |= (uint64_t)1 << (cell&63);
+	}
+	else
+	{
+		*word &= ~((uint64_t)1 << (cell&63));
+	}
 }
 
 /**
- * Getter method for the amount of players that are considered while doing the search for the next move.
+ * Marks the rating of a cell as outdated, so that it is updated by the next evaluation.
  *
- * @return The amount of players in the list of next Players
+ * @param cell - The cell which rating depends on a change
  */
-uint8_t getAmountOfConsideredPlayers()
+inline void Map::markCellRatingOutdated(uint16_t cell)
 {
-	return nextPlayers.size();
+	if(!isCellRatingOutdated[cell])
+	{
+		isCellRatingOutdated[cell] = true;
+		outdatedCellRatings.push_back(cell);
+	}
 }
 
 /**
- * Getter function for the width of the board.
- *
- * @return The width of the board
+ * Rates the stones on all cells that are marked as outdated again and moves their ratings
+ * to the sum of their current colour. Cells without a stone are rated with 0.
  */
-uint16_t getWidth()
+void Map::updateCellRatings()
 {
-	return width;
+	for(vector<uint16_t>::iterator it=outdatedCellRatings.begin(); it!=outdatedCellRatings.end(); ++it)
+	{
+		uint16_t cell = *it;
+		colourRating[cellRatingColour[cell]] -= cellRating[cell];
+
+		char state = board[cell];
+		if(state!=0 && state<=getAmountOfPlayers())
+		{
+			cellRating[cell] = getStabilityRating(cell);
+			if(isFrontierStone(cell))
+			{
+				cellRating[cell] += WEIGHT_Frontier*topology->existentCell[cell].influence;
+			}
+			cellRatingColour[cell] = state;
+		}
+		else
+		{
+			cellRating[cell] = 0;
+			cellRatingColour[cell] = 0;
+		}
+
+		colourRating[cellRatingColour[cell]] += cellRating[cell];
+		isCellRatingOutdated[cell] = false;
+	}
+
+	outdatedCellRatings.clear();
 }
 
 /**
- * Getter function for the height of the board.
+ * Appends a move to a list of moves.
  *
- * @return The height of the board
+ * @param moves  - The list the move is added to
+ * @param cell   - The cell of the move
+ * @param player - The player who makes the move
+ * @param choice - The choice for choice or bonus cells, 0 otherwise
  */
-uint16_t getHeight()
+inline void Map::addMove(MoveList& moves, uint16_t cell, uint8_t player, uint8_t choice)
 {
-	return height;
+	Move& move = moves.moves[moves.count++];
+	move.x = topology->reverseOffsetX[cell];
+	move.y = topology->reverseOffsetY[cell];
+	move.player = player;
+	move.choice = choice;
+	move.cell = cell;
 }
 
 /**
- * Returns the offset of a cell at the coordinates (x,y).
+ * Sets the stability flag of a cell on one line and records the change if a move is recorded.
+ * Flags that become set only for the current stability are remembered for resetStableState().
  *
- * @param x - The x coordinate of the cell that should get returned
- * @param y - The y coordinate of the cell that should get returned
- * @return The offset of the cell for the intern arrays
+ * @param index - The index of the flag, 4*cell+line, plus LINE_COUNT*getAmountOfCells() for the flags a reset would give
+ * @param value - The new value of the flag
  */
-uint16_t getOffset(uint16_t x, uint16_t y)
+inline void Map::setStoneStable(uint32_t index, bool value)
 {
-	return offsetMap[x][y];
+	if(isStoneStable[index]==value)
+	{
+		return;
+	}
+
+	if(isRecording)
+	{
+		stabilityJournal.push_back(index);
+	}
+	isStoneStable[index] = value;
+	stableLineCount[index/LINE_COUNT] += value ? 1 : -1;
+
+	uint32_t resetOffset = LINE_COUNT*getAmountOfCells();
+	if(index<resetOffset)
+	{
+		markCellRatingOutdated(index/LINE_COUNT);
+	}
+	if((index<resetOffset) ? (value && !isStoneStable[index+resetOffset]) : (!value && isStoneStable[index-resetOffset]))
+	{
+		stabilityDifferences.push_back(index%resetOffset);
+	}
 }
 
 /**
- * Computes the x and y coordinate for a give offset.
+ * Sets the amount of free cells on a line and records the change if a move is recorded.
  *
- * @param x - Pointer to integer that gets set to the x coordinate of the cell
- * @param y - Pointer to integer that gets set to the y coordinate of the cell
- * @param offset - The offset of the cell which coordinates are requested
+ * @param line   - The index of the line
+ * @param amount - The new amount of free cells on that line
  */
-void reverseOffset(int* x, int* y, uint16_t offset)
+inline void Map::setFreeCellsOnLine(uint32_t line, uint16_t amount)
 {
-	*x = reverseOffsetX[offset];
-	*y = reverseOffsetY[offset];
+	if(amountOfFreeCellsOnLine[line]==amount)
+	{
+		return;
+	}
+
+	if(isRecording)
+	{
+		lineJournal.push_back(make_pair(line, amountOfFreeCellsOnLine[line]));
+	}
+	amountOfFreeCellsOnLine[line] = amount;
 }
 
 /**
- * Getter function for the amount of cells on the board.
+ * Changes the amount of override stones and bombs of a player and keeps the hash key up to date.
  *
- * @return The amount of cells on the board
+ * @param player		 - The player whose stones change
+ * @param overrideChange - The amount of override stones that is added
+ * @param bombChange	 - The amount of bombs that is added
  */
-uint16_t getAmountOfCells()
+inline void Map::changeStoneCounts(uint8_t player, int overrideChange, int bombChange)
 {
-	return cellcount;
+	hashKey ^= getStoneCountKey(player);
+	overrideStones[player] += overrideChange;
+	numberOfBombs[player] += bombChange;
+	hashKey ^= getStoneCountKey(player);
 }
 
 /**
- * Getter function for the amount of players.
+ * Returns the part of the hash key that belongs to the override stones and bombs of a player.
  *
- * @return The amount of players that started the game
+ * @param player - The player whose stones are hashed
+ * @return The key of the amount of override stones and bombs
  */
-uint8_t getAmountOfPlayers()
+inline uint64_t Map::getStoneCountKey(uint8_t player)
 {
-	return amountOfPlayers;
+	return getZobristKey(ZOBRIST_STONE_COUNT, (player<<24) | (overrideStones[player]<<12) | numberOfBombs[player]);
 }
 
 /**
- * Getter function for the amount of players that have not been disqualified.
+ * Returns the part of the hash key that belongs to the player map.
  *
- * @return The amount of players that have not been disqualified
+ * @return The key of the colours the players currently own
  */
-uint8_t getAmountOfActivePlayers()
+uint64_t Map::getPlayerMapKey()
 {
-	return amountOfActivePlayers;
+	uint64_t key = 0;
+	for(uint8_t p=1; p<=getAmountOfPlayers(); ++p)
+	{
+		key ^= getZobristKey(ZOBRIST_PLAYER_MAP, (p<<8) | playerMap[p]);
+	}
+	return key;
 }
 
 /**
- * Getter function for disqualifying status of the player.
- * NOTE: Param player starts with player 1 as the number 1!
+ * Allocates the arrays of the dynamic part of the board in the sizes given by the topology.
+ * Without a topology nothing is allocated yet.
+ */
+void Map::allocateState()
+{
+	if(!topology)
+	{
+		board = NULL;
+		amountOfFreeCellsOnLine = NULL;
+		isStoneStable = NULL;
+		stableLineCount = NULL;
+		cellRating = NULL;
+		cellRatingColour = NULL;
+		isCellRatingOutdated = NULL;
+		bitboard = NULL;
+		stoneNeighbours = NULL;
+		return;
+	}
+
+	board = new char[getAmountOfCells()+BOARD_PADDING];
+	memset(board+getAmountOfCells(), 0, BOARD_PADDING);
+	amountOfFreeCellsOnLine = new uint16_t[topology->lineCount];
+	isStoneStable = new bool[2*LINE_COUNT*getAmountOfCells()];
+	stableLineCount = new uint8_t[2*getAmountOfCells()];
+	cellRating = new int[getAmountOfCells()];
+	cellRatingColour = new uint8_t[getAmountOfCells()];
+	isCellRatingOutdated = new bool[getAmountOfCells()];
+	bitboard = new uint64_t[(LINE_COUNT*(getAmountOfPlayers()+1)+COMPACTED_SLOT_COUNT)*topology->bitboardWordCount];
+	stoneNeighbours = new uint8_t[getAmountOfCells()];
+}
+
+/**
+ * Frees the arrays of the dynamic part of the board.
+ */
+void Map::releaseState()
+{
+	delete [] board;
+	delete [] amountOfFreeCellsOnLine;
+	delete [] isStoneStable;
+	delete [] stableLineCount;
+	delete [] cellRating;
+	delete [] cellRatingColour;
+	delete [] isCellRatingOutdated;
+	delete [] bitboard;
+	delete [] stoneNeighbours;
+}
+
+/**
+ * Recalculates the key of the order in which the players move.
+ */
+void Map::updateTurnOrderKey()
+{
+	turnOrderKey = 0;
+	for(uint8_t i=0; i<amountOfConsideredPlayers; ++i)
+	{
+		turnOrderKey ^= getZobristKey(ZOBRIST_TURN_ORDER, (i<<8) | nextPlayers[i]);
+	}
+	for(uint8_t p=1; p<=MAX_PLAYER; ++p)
+	{
+		if(disqualified[p])
+		{
+			turnOrderKey ^= getZobristKey(ZOBRIST_DISQUALIFIED, p);
+		}
+	}
+}
+
+/**
+ * Sets or clears the bits of a cell in all bitboards the given state belongs to.
  *
- * @param player - The slot of the player that should get disqualified.
+ * @param cell  - The cell which bits are changed
+ * @param state - The state which determines the bitboards that are changed
+ * @param isSet - True to set the bits, false to clear them
  */
-void disqualifyPlayer(uint8_t player)
+inline void Map::updateBitboards(uint16_t cell, char state, bool isSet)
 {
-	amountOfActivePlayers--;
-	disqualified[player] = true;
+	int slot=-1;
+	int compactedSlot=-1;
+
+	if(state==0)
+	{
+		slot=0;
+		compactedSlot=EMPTY_CELLS;
+	}
+	else if(state>0 && state<=getAmountOfPlayers())
+	{
+		slot=state;
+	}
+	else if(state=='c' || state=='b' || state=='i')
+	{
+		slot=0;
+		compactedSlot=SPECIAL_CELLS;
+	}
+	else if(state=='x')
+	{
+		compactedSlot=SPECIAL_CELLS;
+	}
+	else if(state==NO_STONE)
+	{
+		compactedSlot=HOLE_CELLS;
+	}
+
+	if(slot>=0)
+	{
+		for(int orientation=0; orientation<LINE_COUNT; ++orientation)
+		{
+			int bit = topology->cellToBit[orientation][cell];
+			uint64_t* word = getBitboard(orientation, slot) + (bit>>6);
+			if(isSet)
+			{
+				*word |= (uint64_t)1 << (bit&63);
+			}
+			else
+			{
+				*word &= ~((uint64_t)1 << (bit&63));
+			}
+		}
+	}
+
+	if(compactedSlot>=0)
+	{
+		uint64_t* word = getBitboard(LINE_COUNT, compactedSlot) + (cell>>6);
+		if(isSet)
+		{
+			*word |= (uint64_t)1 << (cell&63);
+		}
+		else
+		{
+			*word &= ~((uint64_t)1 << (cell&63));
+		}
+	}
 }
 
+////////////////////////////
+////			     	////
+////  PUBLIC FUNCTIONS  ////
+////                    ////
+////////////////////////////
+
 /**
- * Getter function for getting the disqualification status of the player.
- * NOTE: Param player starts with player 1 as the number 1!
+ * Set a flag whether override stones should be considered for the validation of playing phase move. 
+ * This should be used to reduce the branching factor during move search. 
+ * It is most likely that no override stones will be saved for the end of the game anyway.
  *
- * @param player - The player whose disqualification status should get checked
- * @return Returns true if the player has been disqualified, false otherwise
+ * @param toConsider - True if override stones should be considered, false otherwise
  */
-bool isDisqualified(uint8_t player)
+void setConsiderOverrideStones(bool toConsider)
 {
-	return disqualified[player];
+	toConsiderOverrideStones = toConsider;
 }
 
 /**
- * Frees all memory allocated for the static part of the board.
- * This function should always be called at the end of a game to avoid memory leaks.
+ * Getter function for the flag that indicates if override stones are being considered.
+ *
+ * @return True if override stones are being considered, false otherwise
  */
-void freeAllocatedMemory()
+bool getConsiderOverrideStones()
 {
-	delete[] existentCell;
-	delete[] cellsOnLine;
+	return toConsiderOverrideStones;
 }
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <istream>
 #include <vector>
+#include <memory>
 #include <limits.h>
 
 #define MAX_PLAYER 8
@@ -41,8 +42,197 @@ typedef struct Move
 	uint16_t y;
 	uint8_t player;
 	uint8_t choice;
+	uint16_t cell; ///< The index of the cell at (x,y)
 } Move;
 
+/**
+ * A list of moves that is stored in a buffer of the caller, so that every node of the
+ * search can keep its list on the stack. The buffer needs space for getMaximumMoveCount() moves.
+ */
+typedef struct MoveList
+{
+	Move* moves;
+	int count;
+} MoveList;
+
+/**
+ * How closely the stones of an opponent interact with the stones of a player, as measured by Map::getInteractions().
+ */
+typedef struct Interaction
+{
+	int distance;		///< The fewest steps from a stone of the player to a stone of the opponent, INT_MAX if none is reachable
+	int sharedLines;	///< The lines with stones of both players that still have free cells
+	int contacts;		///< The stones of the player that have a stone of the opponent as neighbour
+} Interaction;
+
+/**
+ * Contains the information needed to take back a move made with Map::makeMove().
+ * The recoloured cells, the changed stability flags and the changed line counters are stored
+ * in the journals of the map, the record only remembers where its entries begin.
+ */
+typedef struct UndoRecord
+{
+	uint64_t hashKey;
+	uint32_t cellJournalSize;
+	uint32_t stabilityJournalSize;
+	uint32_t lineJournalSize;
+	uint32_t stabilityDifferenceCount;
+	uint16_t overrideStones; ///< The override stones of the moving player before the move
+	uint16_t numberOfBombs; ///< The bombs of the moving player before the move
+	uint16_t amountOfInversionStones;
+	uint16_t amountOfChoiceStones;
+	uint8_t playerMap[MAX_PLAYER+1];
+	uint8_t player;
+} UndoRecord;
+
+/**
+ * The static part of a map, which does not change during a game: the size of the board, the cells and their
+ * neighbours, the lines, the rays and the tables derived from them, as well as the start position of the map.
+ * It is built once by the parser and shared by all the maps that are played on it, so that one process can
+ * hold several maps and games at once.
+ */
+class MapTopology
+{
+	public:
+		MapTopology(istream& is);
+		~MapTopology();
+
+		MapTopology(const MapTopology&) = delete;
+		MapTopology& operator=(const MapTopology&) = delete;
+
+	private:
+		friend class Map;
+
+		uint16_t width;
+		uint16_t height;
+		int cellcount;
+		int lineCount;
+		int bombExplosionRadius;
+		int amountOfPlayers;
+
+		/**
+		 * The start position given by the map, which every new game on this topology begins with.
+		 */
+		char* startBoard;
+		uint16_t startOverrideStones;
+		uint16_t startBombs;
+
+		/**
+		 * Contains the offset of the cells on the board (in class Map) and existentCell to the right cell.
+		 */
+		int offsetMap[MAX_WIDTH][MAX_HEIGHT];
+
+		/**
+		 * Contains the x coordinate of the cell that is at offset position in the array.
+		 */
+		int reverseOffsetX[MAX_WIDTH * MAX_HEIGHT];
+
+		/**
+		 * Contains the y coordinate of the cell that is at offset position in the array.
+		 */
+		int reverseOffsetY[MAX_WIDTH * MAX_HEIGHT];
+
+		/**
+		 * Contains all information regarding neighbours and their direction of the cells on the board.
+		 * Slots correlate with the board in the class Map.
+		 */
+		Cell* existentCell;
+
+		vector<int>* cellsOnLine;
+
+		/**
+		 * Contains the amount of 64 bit words needed to store one bit for every cell.
+		 */
+		int bitboardWordCount;
+
+		/**
+		 * Contains for every line orientation the bit position of each cell in the rotated bitboards.
+		 * The horizontal orientation is equal to the compacted cell index.
+		 */
+		uint16_t* cellToBit[LINE_COUNT];
+
+		/**
+		 * Contains for every line orientation the cell that is stored at a bit position of the rotated bitboards.
+		 */
+		uint16_t* bitToCell[LINE_COUNT];
+
+		/**
+		 * Contains for every direction the bits of the cells that are reached by a trivial step in that direction
+		 * from the cell on the neighbouring bit. Shifting a rotated bitboard by one bit and masking it with this
+		 * moves every stone by one cell into that direction.
+		 */
+		uint64_t* lineContinuation[DIRECTION_COUNT];
+
+		/**
+		 * Contains the cells of all rays stored one after another. The ray of a cell in one direction
+		 * lists every cell that is reached by following the neighbours, including the direction changes
+		 * of <->-transitions, until the border of the map is reached or the ray would return to its start cell.
+		 */
+		uint16_t* rayCells;
+
+		/**
+		 * Contains for every cell and direction the index of the first cell of its ray in rayCells.
+		 * A ray ends where the ray of the next slot begins, so there is one more entry than rays.
+		 */
+		uint32_t* rayBegin;
+
+		/**
+		 * Contains for every cell the first RAY_PREFIX_LENGTH cells of its rays, ordered by their position in
+		 * the ray and then by direction, so that one step into all 8 directions lies next to each other.
+		 * Rays that are shorter are filled up with getAmountOfCells(), the first padding cell of the board.
+		 */
+		int32_t* rayPrefix;
+
+		/**
+		 * Marks all cells that have at least one ray which continues through a <->-transition.
+		 * Captures on these cells can not be found with the bitboards alone.
+		 */
+		uint64_t* transitionCells;
+
+		/**
+		 * Contains for every cell the cells that have it as a neighbour, stored one after another.
+		 * The cells linking to a cell are found from linkingBegin[cell] up to linkingBegin[cell+1],
+		 * a cell is listed once for every direction in which it links to that cell.
+		 */
+		uint16_t* linkingCells;
+		uint32_t* linkingBegin;
+
+		/**
+		 * Contains the highest amount of cells a single move can recolour, which is the total length of the rays of a cell.
+		 */
+		int maximumCaptureCount;
+
+		/**
+		 * Contains the highest amount of moves a player can have in one position.
+		 * Every cell can be a move, choice cells once for every player and bonus cells twice.
+		 */
+		int maximumMoveCount;
+
+		/**
+		 * Contains the random keys of the cell states used for the hash keys of the maps, one for every
+		 * state of every cell. The states are numbered as given by zobristState.
+		 */
+		uint64_t* zobristKeys;
+
+		/**
+		 * Contains for every state of a cell its index among the keys of one cell in zobristKeys.
+		 */
+		uint8_t zobristState[NO_STONE+1];
+
+		/**
+		 * The weights of the override stones and bombs in the evaluation, which depend on how many
+		 * cells the stones on this map influence.
+		 */
+		int overrideStoneWeight;
+		int bombWeight;
+
+		void addNeighbour(uint16_t x1, uint16_t y1, uint8_t dir1, uint16_t x2, uint16_t y2, uint8_t dir2);
+		bool isTrivialStep(uint16_t cell, uint8_t dir) const;
+		int countBits(const uint64_t* bits) const;
+		void shiftBitboard(const uint64_t* in, uint64_t* out, uint8_t dir, int first, int last) const;
+		bool hasCapturesGathered(const char* board, uint16_t start, char colour) const;
+};
+
 /**
  * This class contains the dynamic information of the board.
  *
@@ -52,16 +242,24 @@ class Map
 {
 	public:
 		Map(istream& is);
+		Map(shared_ptr<const MapTopology> topology);
 		Map();
 		~Map();
 		void copy(Map& toCopy);
 		void draw();
 
+		shared_ptr<const MapTopology> getTopology();
+
 		void initializeNeighbourList(uint8_t player);
+		void getInteractions(uint8_t player, Interaction* interactions);
 
 		bool isPlayingPhaseMoveValid(uint16_t start, uint8_t player, uint8_t choice);
+		bool isPlayingPhaseMoveValid(uint16_t start, uint8_t player, uint8_t choice, uint16_t* captures);
 		bool isBombingPhaseMoveValid(uint16_t start, uint8_t player, uint8_t choice);
+		bool makeMove(uint16_t start, uint8_t player, uint8_t choice, bool isPlayingPhase, uint16_t* captures, UndoRecord& undo);
+		void unmakeMove(UndoRecord& undo);
 		int64_t evaluateForPlayingPhase(uint8_t player);
+		int64_t evaluateForPlayingPhaseFromScratch(uint8_t player);
 		int64_t evaluateForBombingPhase(uint8_t player);
 		int64_t evaluateForEndOfGame(uint8_t player);
 
@@ -69,10 +267,35 @@ class Map
 		int getAmountOfOverrideStones(uint8_t player);
 		int getAmountOfBombs(uint8_t player);
 		int getAmountOfInversionStones();
+		uint64_t getHashKey(uint8_t player, bool isPlayingPhase);
 
 		int getScore(uint8_t playerID);
+		int getMobility(uint8_t player, uint64_t* moves, uint64_t* overrideMoves=NULL);
+		int getNextCandidateCell(int cell, bool isPlayingPhase);
+		void generateMoves(uint8_t player, bool isPlayingPhase, MoveList& moves);
+
+		uint8_t getNextPlayer(uint8_t lastPlayer);
+		uint8_t getAmountOfConsideredPlayers();
+		void disqualifyPlayer(uint8_t player);
+		bool isDisqualified(uint8_t player);
+		uint8_t getAmountOfActivePlayers();
+
+		uint16_t getWidth();
+		uint16_t getHeight();
+		uint16_t getOffset(uint16_t x, uint16_t y);
+		void reverseOffset(int* x, int* y, uint16_t offset);
+		uint16_t getAmountOfCells();
+		int getMaximumCaptureCount();
+		int getMaximumMoveCount();
+		uint8_t getAmountOfPlayers();
 
 	private:
+		/**
+		 * The static part of the map, shared with all other maps of the same game.
+		 * Maps created with the default constructor get it from the first map copied into them.
+		 */
+		shared_ptr<const MapTopology> topology;
+
 		uint16_t overrideStones[MAX_PLAYER+1];
 		uint16_t numberOfBombs[MAX_PLAYER+1];
 		uint8_t playerMap[MAX_PLAYER+1];
@@ -82,39 +305,124 @@ class Map
 		uint16_t amountOfInversionStones;
 		uint16_t amountOfChoiceStones;
 
+		/**
+		 * The players that got disqualified and the players that are considered by the search,
+		 * in the order in which they move.
+		 */
+		bool disqualified[MAX_PLAYER+1];
+		uint8_t amountOfActivePlayers;
+		uint8_t nextPlayers[MAX_PLAYER];
+		uint8_t amountOfConsideredPlayers;
+
+		/**
+		 * Contains the key of the order in which the players move, given by the considered players and
+		 * the disqualified ones. It is added to the hash keys, as it changes the moves that follow a position.
+		 */
+		uint64_t turnOrderKey;
+
+		/**
+		 * Zobrist key of the board, the player map and the override stones and bombs of every player.
+		 * It is updated with every change, getHashKey() adds the information that is not part of a map.
+		 */
+		uint64_t hashKey;
+
+		/**
+		 * Word-parallel copy of the board. For every line orientation there is one bitboard for
+		 * each player colour plus one (slot 0) for the cells that end a capturing ray without
+		 * capturing (empty, choice, inversion and bonus cells). The bits are ordered such that
+		 * cells that follow each other on a line are neighbouring bits, the horizontal orientation
+		 * uses the compacted cell index. Behind them follow the empty, special, hole and candidate bitboards.
+		 */
+		uint64_t* bitboard;
+
+		/**
+		 * Contains for every cell in how many directions its neighbour holds a stone.
+		 */
+		uint8_t* stoneNeighbours;
+
+		/**
+		 * Journals of the changes done by the moves made with makeMove(). Changes are only
+		 * recorded while isRecording is set, for the cells and lines the previous value is stored,
+		 * for the stability flags only the index as the previous value is the negated current one.
+		 */
+		bool isRecording;
+		vector<pair<uint16_t, char> > cellJournal;
+		vector<uint32_t> stabilityJournal;
+		vector<pair<uint32_t, uint16_t> > lineJournal;
+
+		/**
+		 * The stability flags are kept twice in isStoneStable. The first LINE_COUNT*getAmountOfCells()
+		 * flags are the ones the evaluation uses, they only get cleared by resetStableState().
+		 * Behind them follow the flags that a reset would give for the current board, which are
+		 * updated with every move. The flags that are only set in the first half are listed here,
+		 * so that a reset only has to clear those. The list may contain flags that are equal by now.
+		 */
+		vector<uint32_t> stabilityDifferences;
+
+		/**
+		 * Contains for every cell on how many lines its stone is stable, in the same two halves as
+		 * isStoneStable, so that the evaluation does not have to count the flags again.
+		 * A stone with LINE_COUNT stable lines is stable and spreads its stability.
+		 */
+		uint8_t* stableLineCount;
+
+		/**
+		 * Parts of evaluateForPlayingPhase() that are kept up to date between the evaluations.
+		 * Every stone has its rating (stability and frontier) stored together with the colour it
+		 * was added to, and the ratings of all stones of one colour are summed up in colourRating.
+		 * Changing a cell only marks the ratings as outdated that depend on it, they are updated
+		 * by the next evaluation.
+		 */
+		int64_t colourRating[MAX_PLAYER+1];
+		int* cellRating;
+		uint8_t* cellRatingColour;
+		bool* isCellRatingOutdated;
+		vector<uint16_t> outdatedCellRatings;
+
+		/**
+		 * Buffers for the cells that are visited while the stability is updated after a move.
+		 */
+		vector<uint16_t> stabilityWorklist;
+		vector<uint16_t> stabilityChangedCells;
+
+		void allocateState();
+		void releaseState();
+		void updateTurnOrderKey();
+		uint64_t* getBitboard(int orientation, int slot);
+		void setState(uint16_t cell, char state);
+		void writeState(uint16_t cell, char state);
+		void updateCandidateState(uint16_t cell);
+		void markCellRatingOutdated(uint16_t cell);
+		void updateCellRatings();
+		void updateBitboards(uint16_t cell, char state, bool isSet);
+		void setStoneStable(uint32_t index, bool value);
+		void setFreeCellsOnLine(uint32_t line, uint16_t amount);
+		void changeStoneCounts(uint8_t player, int overrideChange, int bombChange);
+		uint64_t getStoneCountKey(uint8_t player);
+		uint64_t getPlayerMapKey();
+		void rewindStabilityJournals(uint32_t stabilityJournalSize, uint32_t lineJournalSize);
+
 		bool isStoneReachable(uint16_t cell);
 
 		int getStabilityRating(uint16_t cell);
-		bool isStable(uint16_t cell);
+		bool isStable(uint16_t cell, uint32_t offset=0);
+		bool isBaseStable(uint16_t cell, int line);
 		bool isFrontierStone(uint16_t cell);
 		bool isMoveValid(uint16_t start, uint8_t player);
+		bool hasCaptures(uint16_t start, uint8_t player);
+		void addMove(MoveList& moves, uint16_t cell, uint8_t player, uint8_t choice);
 
 		uint8_t getPlayerStoneOwnership(uint8_t state);
 		void adaptStableState();
 		void resetStableState();
-		std::vector<int> getMoveCaptures(uint16_t start, uint8_t player);
-		void bombCell(uint16_t start, int depth);
-		void addNeighbour(uint16_t x1, uint16_t y1, uint8_t dir1, uint16_t x2, uint16_t y2, uint8_t dir2);
+		void invalidateStableState(uint16_t start, uint16_t* captures, int captureCount);
+		void updateStableState(uint16_t start, uint16_t* captures, int captureCount);
+		void spreadStableState(uint32_t offset);
+		int getMoveCaptures(uint16_t start, uint8_t player, uint16_t* captures);
+		void bombCell(uint16_t start, int depth, uint8_t* hit);
 };
 
 void setConsiderOverrideStones(bool toConsider);
 bool getConsiderOverrideStones();
-uint8_t getNextPlayer(uint8_t lastPlayer);
-void resetNextPlayerList(uint8_t player);
-uint8_t getAmountOfConsideredPlayers();
-
-uint16_t getWidth();
-uint16_t getHeight();
-uint16_t getOffset(uint16_t x, uint16_t y);
-void reverseOffset(int* x, int* y, uint16_t  offset);
-
-uint16_t getAmountOfCells();
-uint8_t getAmountOfPlayers();
-uint8_t getAmountOfActivePlayers();
-
-void disqualifyPlayer(uint8_t player);
-bool isDisqualified(uint8_t player);
-
-void freeAllocatedMemory();
 
 #endif
@@ -0,0 +1,242 @@
+/**
+ * The time manager decides when an iterative deepening search stops starting new iterations.
+ * Instead of a fixed fraction of the search time, it predicts the cost of the next iteration
+ * from the node counts and times of the iterations already finished during the current game.
+ **/
+
+#include <iostream>
+#include <cmath>
+
+#include "timemanager.h"
+
+/**
+ * Creates a time manager without any measurements, which predicts the default branching factor.
+ */
+TimeManager::TimeManager()
+{
+	phase=0;
+	players=0;
+	hasDeadline=false;
+	deadline=chrono::steady_clock::time_point::max();
+
+	deadlineHits=0;
+	searchesInTime=0;
+	searchCount=0;
+	depthSum=0;
+
+	resetGame();
+}
+
+/**
+ * Drops all measurements, as they belong to another game.
+ */
+void TimeManager::resetGame()
+{
+	for(int p=0; p<2; ++p)
+	{
+		for(int i=0; i<=MAX_PLAYER; ++i)
+		{
+			// The default branching factor is part of the fit, until it has decayed by the measurements
+			branchingLogSum[p][i]=log(DEFAULT_BRANCHING_FACTOR);
+			branchingWeight[p][i]=1;
+		}
+		gameNodes[p]=0;
+		gameSeconds[p]=0;
+		for(int d=0; d<=MAX_RECORDED_DEPTH; ++d)
+		{
+			depthNodes[p][d]=0;
+		}
+	}
+}
+
+/**
+ * Starts the time measurement of a search.
+ *
+ * @param map - The position that is searched, the measurements are dropped if it belongs to another game
+ * @param isPlayingPhase - Set if we are in the playing phase, unset for the bombing phase
+ * @param searchTime - The time limit of the search in ms, a negative value if the search has no deadline
+ */
+void TimeManager::startSearch(Map& map, bool isPlayingPhase, int searchTime)
+{
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+	if(map.getTopology()!=game)
+	{
+		game = map.getTopology();
+		resetGame();
+	}
+
+	phase = isPlayingPhase ? 0 : 1;
+	players = map.getAmountOfActivePlayers();
+	for(int d=0; d<=MAX_RECORDED_DEPTH; ++d)
+	{
+		depthNodes[phase][d] *= DEPTH_NODES_DECAY;
+	}
+	hasDeadline = searchTime>=0;
+	deadline = hasDeadline ? now+chrono::milliseconds(searchTime) : chrono::steady_clock::time_point::max();
+	iterationStart = now;
+	iterations.clear();
+}
+
+/**
+ * Starts the time measurement of the next iteration.
+ */
+void TimeManager::startIteration()
+{
+	iterationStart = chrono::steady_clock::now();
+}
+
+/**
+ * Records an iteration that was searched completely. Another pass with the same depth,
+ * e.g. after the aspiration window failed, is added to the record of the depth.
+ *
+ * @param depth - The search depth of the iteration
+ * @param nodes - The nodes searched by the iteration
+ */
+void TimeManager::finishIteration(int depth, uint64_t nodes)
+{
+	double seconds = chrono::duration<double>(chrono::steady_clock::now()-iterationStart).count();
+
+	gameNodes[phase] += nodes;
+	gameSeconds[phase] += seconds;
+
+	if(!iterations.empty() && iterations.back().depth==depth)
+	{
+		iterations.back().nodes += nodes;
+		iterations.back().seconds += seconds;
+		recordDepthNodes(depth, iterations.back().nodes);
+		return;
+	}
+
+	// Shrinking iterations are answered by the transposition table and say nothing about the branching factor
+	if(!iterations.empty() && iterations.back().depth==depth-1 && iterations.back().nodes>0 && nodes>iterations.back().nodes)
+	{
+		double ratio = (double)nodes/iterations.back().nodes;
+		branchingLogSum[phase][players] = branchingLogSum[phase][players]*BRANCHING_FACTOR_DECAY + log(ratio);
+		branchingWeight[phase][players] = branchingWeight[phase][players]*BRANCHING_FACTOR_DECAY + 1;
+	}
+
+	IterationRecord record = {depth, nodes, seconds};
+	iterations.push_back(record);
+	recordDepthNodes(depth, nodes);
+}
+
+/**
+ * Records an iteration that was stopped by the deadline. Its nodes are a lower bound of the nodes of its depth.
+ *
+ * @param depth - The search depth of the iteration
+ * @param nodes - The nodes searched by the iteration until it was stopped
+ */
+void TimeManager::abortIteration(int depth, uint64_t nodes)
+{
+	gameNodes[phase] += nodes;
+	gameSeconds[phase] += chrono::duration<double>(chrono::steady_clock::now()-iterationStart).count();
+	recordDepthNodes(depth, nodes);
+}
+
+/**
+ * Raises the nodes recorded for a depth, if the given amount is higher.
+ *
+ * @param depth - The search depth
+ * @param nodes - The nodes searched with that depth
+ */
+void TimeManager::recordDepthNodes(int depth, uint64_t nodes)
+{
+	if(depth<=MAX_RECORDED_DEPTH)
+	{
+		depthNodes[phase][depth] = max(depthNodes[phase][depth], (double)nodes);
+	}
+}
+
+/**
+ * Returns whether the predicted time of the next iteration is still left before the deadline.
+ * The prediction multiplies the nodes of the last iteration with the branching factor and divides them by
+ * the nodes searched per second during the game. Without node counts the time of the last iteration is used.
+ */
+bool TimeManager::isNextIterationAffordable()
+{
+	if(iterations.empty() || !hasDeadline)
+	{
+		return true;
+	}
+
+	IterationRecord& last = iterations.back();
+	double predictedSeconds;
+	if(last.nodes>0 && gameNodes[phase]>0 && gameSeconds[phase]>0)
+	{
+		double lastNodes = last.nodes;
+		double nextNodes = 0;
+		if(last.depth<MAX_RECORDED_DEPTH)
+		{
+			lastNodes = max(lastNodes, depthNodes[phase][last.depth]);
+			nextNodes = depthNodes[phase][last.depth+1];
+		}
+		nextNodes = max(nextNodes, lastNodes*getBranchingFactor());
+		predictedSeconds = nextNodes/(gameNodes[phase]/gameSeconds[phase]);
+	}
+	else
+	{
+		predictedSeconds = last.seconds*getBranchingFactor();
+	}
+
+	double secondsLeft = chrono::duration<double>(deadline-chrono::steady_clock::now()).count();
+	return predictedSeconds<secondsLeft;
+}
+
+/**
+ * Updates the statistics with the outcome of the search.
+ *
+ * @param depth - The depth of the last iteration that was searched completely
+ */
+void TimeManager::finishSearch(int depth)
+{
+	searchCount++;
+	depthSum += depth;
+
+	if(hasDeadline)
+	{
+		if(chrono::steady_clock::now()>=deadline)
+		{
+			deadlineHits++;
+		}
+		else
+		{
+			searchesInTime++;
+		}
+	}
+
+	cout << "Branching factor: " << getBranchingFactor() << endl;
+}
+
+/**
+ * Displays how often the predictions failed, so that the deadline was hit, and the average depth reached.
+ */
+void TimeManager::report()
+{
+	cout << "Failures: " << deadlineHits << endl;
+	cout << "Success: " << searchesInTime << endl;
+	if(deadlineHits+searchesInTime>0)
+	{
+		cout << "Deadline hit rate: " << 100.0*deadlineHits/(deadlineHits+searchesInTime) << "%" << endl;
+	}
+	if(searchCount>0)
+	{
+		cout << "Average depth: " << (double)depthSum/searchCount << endl;
+	}
+}
+
+/**
+ * @return The time at which the current search has to return
+ */
+chrono::steady_clock::time_point TimeManager::getDeadline()
+{
+	return deadline;
+}
+
+/**
+ * @return The effective branching factor fitted for the phase and amount of players of the current search
+ */
+double TimeManager::getBranchingFactor()
+{
+	return exp(branchingLogSum[phase][players]/branchingWeight[phase][players]);
+}
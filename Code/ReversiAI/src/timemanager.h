@@ -0,0 +1,83 @@
+#ifndef TIMEMANAGER_H_
+#define TIMEMANAGER_H_
+
+#include <stdint.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "map.h"
+
+#define DEFAULT_BRANCHING_FACTOR 15
+#define BRANCHING_FACTOR_DECAY 0.8 ///< The weight of the older measurements whenever a new one is added to the fit
+#define DEPTH_NODES_DECAY 0.5 ///< The weight of the node counts of the former searches at the start of a search
+#define MAX_RECORDED_DEPTH 100
+
+using namespace std;
+
+/**
+ * The nodes searched by one iteration of an iterative deepening search and the time it took.
+ */
+typedef struct IterationRecord
+{
+	int depth;
+	uint64_t nodes;
+	double seconds;
+} IterationRecord;
+
+/**
+ * Decides whether the next iteration of an iterative deepening search can be finished before the deadline.
+ * The cost of an iteration is predicted from the nodes of the last one, the effective branching factor and
+ * the nodes searched per second. The branching factor is fitted for every phase and amount of active players,
+ * the speed for every phase. As an iteration can be much cheaper than predicted if its positions are found in
+ * the transposition table, the nodes every depth needed in the former searches of the game are a lower bound
+ * of the prediction. All measurements belong to the current game and are dropped once another map is searched.
+ */
+class TimeManager
+{
+	public:
+		TimeManager();
+		void startSearch(Map& map, bool isPlayingPhase, int searchTime);
+		void startIteration();
+		void finishIteration(int depth, uint64_t nodes);
+		void abortIteration(int depth, uint64_t nodes);
+		void finishSearch(int depth);
+		bool isNextIterationAffordable();
+		void report();
+
+		chrono::steady_clock::time_point getDeadline();
+		double getBranchingFactor();
+
+	private:
+		// The game the measurements belong to
+		shared_ptr<const MapTopology> game;
+
+		// The fit of the logarithm of the branching factor for every phase and amount of active players
+		double branchingLogSum[2][MAX_PLAYER+1];
+		double branchingWeight[2][MAX_PLAYER+1];
+
+		// The nodes searched during the current game and the time spend on them, for every phase
+		double gameNodes[2];
+		double gameSeconds[2];
+
+		// The nodes needed for every depth by the former searches of the game, for every phase
+		double depthNodes[2][MAX_RECORDED_DEPTH+1];
+
+		// The current search
+		int phase;
+		int players;
+		bool hasDeadline;
+		chrono::steady_clock::time_point deadline;
+		chrono::steady_clock::time_point iterationStart;
+		vector<IterationRecord> iterations;
+
+		// The statistics of all searches
+		int deadlineHits;
+		int searchesInTime;
+		int searchCount;
+		long depthSum;
+
+		void resetGame();
+		void recordDepthNodes(int depth, uint64_t nodes);
+};
+
+#endif /* TIMEMANAGER_H_ */
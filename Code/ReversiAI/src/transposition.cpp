@@ -0,0 +1,217 @@
+/**
+ * The transposition table stores the results of the positions visited by the search.
+ * A position is identified by the hash key provided by Map::getHashKey(). The table
+ * only gives hints to the search, a wrong entry can change the chosen move but never
+ * break the game, so the rare collisions of two keys are accepted.
+ **/
+
+#include <stdlib.h>		// calloc, free
+
+#include "transposition.h"
+
+// Layout of the data word of an entry
+#define CELL_SHIFT 0
+#define CHOICE_SHIFT 16
+#define DEPTH_SHIFT 24
+#define BOUND_SHIFT 32
+#define AGE_SHIFT 34
+#define AGE_MASK 0x3F
+
+/**
+ * Creates an empty table, memory is only allocated by resize().
+ */
+TranspositionTable::TranspositionTable()
+{
+	words = NULL;
+	bucketMask = 0;
+	size = 0;
+	age = 0;
+	probeCount = 0;
+	hitCount = 0;
+	collisionCount = 0;
+}
+
+/**
+ * Frees the memory of the table.
+ */
+TranspositionTable::~TranspositionTable()
+{
+	free(words);
+}
+
+/**
+ * Allocates the table with the given size, the amount of buckets is rounded down to a power of two.
+ * All entries are lost.
+ *
+ * @param megabytes - The memory the table may use in MB
+ */
+void TranspositionTable::resize(int megabytes)
+{
+	uint64_t bucketSize = ENTRIES_PER_BUCKET*WORDS_PER_ENTRY*sizeof(uint64_t);
+	uint64_t bucketCount = 1;
+	while(2*bucketCount*bucketSize <= ((uint64_t)megabytes<<20))
+	{
+		bucketCount *= 2;
+	}
+
+	bucketMask = bucketCount-1;
+	size = megabytes;
+
+	clear();
+}
+
+/**
+ * Removes all entries from the table. The memory is allocated again instead of being overwritten,
+ * as the zeroed pages of a new allocation are only mapped when the search touches them.
+ */
+void TranspositionTable::clear()
+{
+	free(words);
+	words = (atomic<uint64_t>*)calloc((bucketMask+1)*ENTRIES_PER_BUCKET*WORDS_PER_ENTRY, sizeof(uint64_t));
+}
+
+/**
+ * Has to be called before each search. Entries of older searches are replaced first
+ * and the counters only count the probes and stores of the new search.
+ * If no size has been set yet, the table is allocated with DEFAULT_TABLE_SIZE.
+ */
+void TranspositionTable::startSearch()
+{
+	if(words==NULL)
+	{
+		resize(DEFAULT_TABLE_SIZE);
+	}
+
+	age = (age+1)&AGE_MASK;
+	probeCount = 0;
+	hitCount = 0;
+	collisionCount = 0;
+}
+
+/**
+ * Looks up the entry of a position.
+ *
+ * @param key   - The hash key of the position
+ * @param entry - Is filled with the stored result, if the position was found
+ * @return True if the position was found, false otherwise
+ */
+bool TranspositionTable::probe(uint64_t key, TranspositionEntry& entry)
+{
+	probeCount.fetch_add(1, memory_order_relaxed);
+
+	atomic<uint64_t>* bucket = words + (key&bucketMask)*ENTRIES_PER_BUCKET*WORDS_PER_ENTRY;
+	for(int i=0; i<ENTRIES_PER_BUCKET; ++i)
+	{
+		uint64_t check = bucket[WORDS_PER_ENTRY*i].load(memory_order_relaxed);
+		uint64_t score = bucket[WORDS_PER_ENTRY*i+1].load(memory_order_relaxed);
+		uint64_t data = bucket[WORDS_PER_ENTRY*i+2].load(memory_order_relaxed);
+
+		// Empty entries have a depth of 0, as leafs are never stored
+		if((check^score^data)==key && ((data>>DEPTH_SHIFT)&0xFF)!=0)
+		{
+			entry.score = (int64_t)score;
+			entry.cell = (data>>CELL_SHIFT)&0xFFFF;
+			entry.choice = (data>>CHOICE_SHIFT)&0xFF;
+			entry.depth = (data>>DEPTH_SHIFT)&0xFF;
+			entry.bound = (data>>BOUND_SHIFT)&0x3;
+
+			hitCount.fetch_add(1, memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Stores the result of a position. An existing entry of the position is only replaced
+ * by a result of at least the same depth. Otherwise the entry of the bucket is replaced
+ * which belongs to an older search or has the lowest depth.
+ *
+ * @param key   - The hash key of the position
+ * @param entry - The result of the search of the position, its depth has to be at least 1
+ */
+void TranspositionTable::store(uint64_t key, TranspositionEntry& entry)
+{
+	atomic<uint64_t>* bucket = words + (key&bucketMask)*ENTRIES_PER_BUCKET*WORDS_PER_ENTRY;
+
+	int replaced = 0;
+	int lowestValue = INT32_MAX;
+	bool isCollision = false;
+
+	for(int i=0; i<ENTRIES_PER_BUCKET; ++i)
+	{
+		uint64_t check = bucket[WORDS_PER_ENTRY*i].load(memory_order_relaxed);
+		uint64_t score = bucket[WORDS_PER_ENTRY*i+1].load(memory_order_relaxed);
+		uint64_t data = bucket[WORDS_PER_ENTRY*i+2].load(memory_order_relaxed);
+
+		int depth = (data>>DEPTH_SHIFT)&0xFF;
+		bool isCurrent = ((data>>AGE_SHIFT)&AGE_MASK)==age;
+
+		if((check^score^data)==key && depth!=0)
+		{
+			if(depth>entry.depth && isCurrent)
+			{
+				return;
+			}
+			replaced = i;
+			isCollision = false;
+			break;
+		}
+
+		// Prefer empty entries, then the ones of older searches, then the ones with the lowest depth
+		int value = depth + (isCurrent ? 256 : 0);
+		if(value<lowestValue)
+		{
+			lowestValue = value;
+			replaced = i;
+			isCollision = depth!=0 && isCurrent;
+		}
+	}
+
+	if(isCollision)
+	{
+		collisionCount.fetch_add(1, memory_order_relaxed);
+	}
+
+	uint64_t data = ((uint64_t)entry.cell<<CELL_SHIFT) | ((uint64_t)entry.choice<<CHOICE_SHIFT)
+				  | ((uint64_t)entry.depth<<DEPTH_SHIFT) | ((uint64_t)entry.bound<<BOUND_SHIFT)
+				  | ((uint64_t)age<<AGE_SHIFT);
+	uint64_t score = (uint64_t)entry.score;
+
+	bucket[WORDS_PER_ENTRY*replaced].store(key^score^data, memory_order_relaxed);
+	bucket[WORDS_PER_ENTRY*replaced+1].store(score, memory_order_relaxed);
+	bucket[WORDS_PER_ENTRY*replaced+2].store(data, memory_order_relaxed);
+}
+
+/**
+ * @return The size of the table in MB
+ */
+int TranspositionTable::getSize()
+{
+	return size;
+}
+
+/**
+ * @return The amount of positions looked up since the start of the search
+ */
+uint64_t TranspositionTable::getProbeCount()
+{
+	return probeCount;
+}
+
+/**
+ * @return The amount of positions found in the table since the start of the search
+ */
+uint64_t TranspositionTable::getHitCount()
+{
+	return hitCount;
+}
+
+/**
+ * @return The amount of entries of the current search that were replaced by another position
+ */
+uint64_t TranspositionTable::getCollisionCount()
+{
+	return collisionCount;
+}
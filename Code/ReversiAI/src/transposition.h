@@ -0,0 +1,67 @@
+#ifndef TRANSPOSITION_H_
+#define TRANSPOSITION_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#define EXACT_BOUND 0
+#define LOWER_BOUND 1
+#define UPPER_BOUND 2
+
+#define ENTRIES_PER_BUCKET 4
+#define WORDS_PER_ENTRY 3
+#define DEFAULT_TABLE_SIZE 64 // in MB
+
+using namespace std;
+
+/**
+ * Contains the result of the search of one position, as it is stored in the transposition table.
+ */
+typedef struct TranspositionEntry
+{
+	int64_t score;
+	uint8_t depth; ///< The depth of the subtree that was searched below the position
+	uint8_t bound; ///< Whether the score is exact, a lower bound or an upper bound of the real value
+	uint16_t cell; ///< The cell of the best move found, NO_CELL if there is none
+	uint8_t choice; ///< The choice of the best move found
+} TranspositionEntry;
+
+/**
+ * A hash table which stores the results of positions that were already searched, so that positions
+ * that are reached through different move orders or again in the next iteration need not be searched twice.
+ *
+ * The entries are grouped into buckets, a position can be stored in every entry of the bucket its key points to.
+ * Every entry consists of three words: the score, the data (depth, bound, age and best move) and the key
+ * combined with both of them by XOR. An entry only counts as found if the three words fit together, so that
+ * the table can be read and written by several threads without locking, as a mixed up entry is ignored.
+ */
+class TranspositionTable
+{
+	public:
+		TranspositionTable();
+		~TranspositionTable();
+		void resize(int megabytes);
+		void clear();
+		void startSearch();
+
+		bool probe(uint64_t key, TranspositionEntry& entry);
+		void store(uint64_t key, TranspositionEntry& entry);
+
+		int getSize();
+		uint64_t getProbeCount();
+		uint64_t getHitCount();
+		uint64_t getCollisionCount();
+
+	private:
+		atomic<uint64_t>* words;
+		uint64_t bucketMask; ///< The amount of buckets minus one, the amount is a power of two
+		int size; ///< The size of the table in MB
+		uint8_t age; ///< Counts the searches, so that entries of old searches are replaced first
+
+		atomic<uint64_t> probeCount;
+		atomic<uint64_t> hitCount;
+		atomic<uint64_t> collisionCount;
+};
+
+#endif /* TRANSPOSITION_H_ */
@@ -7,10 +7,6 @@
 #define earlyGame 0
 #define midGame 100
 
-int WEIGHT_Bombs = 0;
-int WEIGHT_OverrideStones = 0;
-
-
 TYPE WEIGHT_ChoiceStone = -10000000;
 TYPE WEIGHT_Frontier = -8;
 
@@ -0,0 +1,204 @@
+/**
+ * A work stealing thread pool, used to search the moves of a node on several threads.
+ * Every thread keeps the tasks it creates in its own deque, so that it can work on them
+ * in the order it created them, while the other threads take the oldest tasks.
+ **/
+
+#include "workstealing.h"
+
+// The index of the current thread in the pool, the thread that started the pool has index 0
+thread_local int workerIndex = 0;
+
+/**
+ * Creates a pool which only consists of the current thread. Call start() to add more threads.
+ */
+WorkStealingPool::WorkStealingPool()
+{
+	isActive = false;
+	isShutdown = false;
+	workers.push_back(new Worker());
+}
+
+/**
+ * Stops all threads of the pool.
+ */
+WorkStealingPool::~WorkStealingPool()
+{
+	shutdown();
+	delete workers[0];
+}
+
+/**
+ * Creates the threads of the pool. This has to be called by the thread that will use the pool,
+ * as it becomes the first thread of the pool. A pool that was started before is shut down first.
+ *
+ * @param threadCount - The amount of threads of the pool, including the current one
+ */
+void WorkStealingPool::start(int threadCount)
+{
+	shutdown();
+
+	workerIndex = 0;
+	isShutdown = false;
+	for(int i=1; i<threadCount; ++i)
+	{
+		workers.push_back(new Worker());
+	}
+	for(int i=1; i<threadCount; ++i)
+	{
+		threads.push_back(thread(&WorkStealingPool::work, this, i));
+	}
+}
+
+/**
+ * Stops and removes all threads of the pool except for the first one.
+ */
+void WorkStealingPool::shutdown()
+{
+	{
+		lock_guard<mutex> guard(stateLock);
+		isShutdown = true;
+	}
+	stateChanged.notify_all();
+
+	for(size_t i=0; i<threads.size(); ++i)
+	{
+		threads[i].join();
+	}
+	threads.clear();
+
+	for(size_t i=1; i<workers.size(); ++i)
+	{
+		delete workers[i];
+	}
+	workers.resize(1);
+}
+
+/**
+ * Wakes the threads of the pool up, so that they steal the tasks of the others.
+ */
+void WorkStealingPool::activate()
+{
+	{
+		lock_guard<mutex> guard(stateLock);
+		isActive = true;
+	}
+	stateChanged.notify_all();
+}
+
+/**
+ * Lets the threads of the pool sleep, once they are done with their current task.
+ */
+void WorkStealingPool::deactivate()
+{
+	lock_guard<mutex> guard(stateLock);
+	isActive = false;
+}
+
+/**
+ * @return The amount of threads of the pool, including the first one
+ */
+int WorkStealingPool::getThreadCount()
+{
+	return workers.size();
+}
+
+/**
+ * @return The index of the current thread in its pool, 0 for the thread that started the pool
+ */
+int WorkStealingPool::getWorkerIndex()
+{
+	return workerIndex;
+}
+
+/**
+ * Adds a task to the back of the deque of the current thread.
+ *
+ * @param task - The task that can be done by any thread of the pool
+ */
+void WorkStealingPool::push(Task task)
+{
+	Worker* worker = workers[workerIndex];
+	lock_guard<mutex> guard(worker->lock);
+	worker->tasks.push_back(task);
+}
+
+/**
+ * Takes the task at the back of the deque of the current thread, if it belongs to the given job.
+ * Older tasks of other jobs are left for the thread that waits for them.
+ *
+ * @param task - Is set to the task taken from the deque
+ * @param data - The data of the job whose tasks are wanted
+ * @return True if a task was taken, false otherwise
+ */
+bool WorkStealingPool::pop(Task& task, void* data)
+{
+	Worker* worker = workers[workerIndex];
+	lock_guard<mutex> guard(worker->lock);
+	if(worker->tasks.empty() || worker->tasks.back().data!=data)
+	{
+		return false;
+	}
+
+	task = worker->tasks.back();
+	worker->tasks.pop_back();
+	return true;
+}
+
+/**
+ * Takes the oldest task of one of the other threads.
+ *
+ * @param thief - The index of the thread that looks for a task
+ * @param task  - Is set to the stolen task
+ * @return True if a task was stolen, false if all other deques are empty
+ */
+bool WorkStealingPool::steal(int thief, Task& task)
+{
+	for(size_t i=1; i<workers.size(); ++i)
+	{
+		Worker* victim = workers[(thief+i)%workers.size()];
+		lock_guard<mutex> guard(victim->lock);
+		if(!victim->tasks.empty())
+		{
+			task = victim->tasks.front();
+			victim->tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * The loop of the threads created by the pool. While the pool is active they steal and execute tasks.
+ *
+ * @param index - The index of the thread in the pool
+ */
+void WorkStealingPool::work(int index)
+{
+	workerIndex = index;
+
+	while(true)
+	{
+		{
+			unique_lock<mutex> guard(stateLock);
+			while(!isActive && !isShutdown)
+			{
+				stateChanged.wait(guard);
+			}
+			if(isShutdown)
+			{
+				return;
+			}
+		}
+
+		Task task;
+		if(steal(index, task))
+		{
+			task.run(task.data, task.index);
+		}
+		else
+		{
+			this_thread::yield();
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#ifndef WORKSTEALING_H_
+#define WORKSTEALING_H_
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+/**
+ * A piece of work that can be executed by any thread of a WorkStealingPool.
+ */
+typedef struct Task
+{
+	void (*run)(void* data, int index);
+	void* data; ///< The data shared by the tasks of one job, e.g. the node whose moves are searched
+	int index; ///< The part of the job done by this task, e.g. the move that is searched
+} Task;
+
+/**
+ * A pool of threads, in which every thread has its own deque of tasks. A thread adds and takes its
+ * own tasks at the back, while idle threads steal tasks from the front of the other deques.
+ * The thread that starts the pool is the first thread of the pool, the others are created by it.
+ * They only look for tasks while the pool is active and sleep otherwise.
+ */
+class WorkStealingPool
+{
+	public:
+		WorkStealingPool();
+		~WorkStealingPool();
+		void start(int threadCount);
+		void shutdown();
+		void activate();
+		void deactivate();
+
+		int getThreadCount();
+		static int getWorkerIndex();
+		void push(Task task);
+		bool pop(Task& task, void* data);
+
+	private:
+		typedef struct Worker
+		{
+			mutex lock;
+			deque<Task> tasks;
+		} Worker;
+
+		vector<Worker*> workers;
+		vector<thread> threads;
+
+		mutex stateLock;
+		condition_variable stateChanged;
+		bool isActive;
+		bool isShutdown;
+
+		void work(int index);
+		bool steal(int thief, Task& task);
+};
+
+#endif /* WORKSTEALING_H_ */